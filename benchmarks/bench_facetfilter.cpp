@@ -0,0 +1,165 @@
+// Times checkbox facet filtering: TweetFilterEngine::filterTweets, which combines FacetIndex
+// postings word-wise, against the per-row QStringList/regex loop it replaced, with a dozen
+// values checked.
+//
+//   bench_facetfilter [size...]     (default: 10000 100000 1000000)
+
+#include "benchmarkcorpus.h"
+#include "tweetrepository.h"
+#include "tweetfilterengine.h"
+#include <QCoreApplication>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include <cstdio>
+#include <limits>
+
+namespace {
+const int kRuns = 7; // Best of; the first run also pays for cold caches
+
+// 9 authors, a sonic tag, a technique tag and a UGen: pool values, so present at every size. A
+// tweet has one author and two tags of each kind, so with more tags checked AND matches nothing.
+FilterCriteria checkedFacets(bool useAndLogic)
+{
+    auto names = [](int count, int stride, QString (*name)(int)) {
+        QStringList result;
+        for (int i = 0; i < count; ++i) result.append(name(i * stride));
+        return result;
+    };
+    FilterCriteria criteria;
+    criteria.useAndLogic = useAndLogic;
+    criteria.checkedAuthors = names(9, 53, BenchmarkCorpus::authorName);
+    criteria.checkedSonicTags = names(1, 1, BenchmarkCorpus::sonicTagName);
+    criteria.checkedTechniqueTags = names(1, 1, BenchmarkCorpus::techniqueTagName);
+    criteria.checkedUgens = names(1, 1, BenchmarkCorpus::ugenName);
+    return criteria;
+}
+
+int checkedCount(const FilterCriteria& criteria)
+{
+    return int(criteria.checkedAuthors.size() + criteria.checkedSonicTags.size() +
+               criteria.checkedTechniqueTags.size() + criteria.checkedUgens.size());
+}
+
+// TweetFilterEngine::filterTweets as it was before the bitmaps, facet part only (no search
+// text, no favorites) and without its per-call qDebug. Per row: QStringList lookups for authors
+// and tags, two regexes over the code for each checked UGen.
+QVector<const TweetData*> perRowFilter(const QVector<TweetData>& allTweets, const FilterCriteria& criteria)
+{
+    QList<QRegularExpression> ugenMethodCheckRegexes;
+    QList<QRegularExpression> ugenFuncCheckRegexes;
+    for (const QString& ugen : criteria.checkedUgens) {
+        QString escapedUgen = QRegularExpression::escape(ugen);
+        ugenMethodCheckRegexes.append(QRegularExpression(QString(R"(\b%1\b(?:\.(?:ar|kr|ir|new)\b|\())").arg(escapedUgen)));
+        ugenFuncCheckRegexes.append(QRegularExpression(QString(R"(\b(?:ar|kr|ir|new)\b\s*\(\s*%1\b)").arg(escapedUgen)));
+    }
+    auto ugenFound = [&](int i, const TweetData& tweet) {
+        return ugenMethodCheckRegexes[i].match(tweet.originalCode).hasMatch() ||
+               ugenFuncCheckRegexes[i].match(tweet.originalCode).hasMatch();
+    };
+
+    auto passes = [&](const TweetData& tweet) {
+        if (criteria.useAndLogic) {
+            if (!criteria.checkedAuthors.isEmpty()) {
+                // The old loop re-tested list membership once per checked author
+                for (int i = 0; i < criteria.checkedAuthors.size(); ++i) {
+                    if (!criteria.checkedAuthors.contains(tweet.author) &&
+                        !(tweet.author.isEmpty() && criteria.checkedAuthors.contains("Unknown"))) {
+                        return false;
+                    }
+                }
+            }
+            for (const QString& reqSonic : criteria.checkedSonicTags) {
+                if (!tweet.sonicTags.contains(reqSonic, Qt::CaseInsensitive)) return false;
+            }
+            for (const QString& reqTechnique : criteria.checkedTechniqueTags) {
+                if (!tweet.techniqueTags.contains(reqTechnique, Qt::CaseInsensitive)) return false;
+            }
+            for (int i = 0; i < criteria.checkedUgens.size(); ++i) {
+                if (!ugenFound(i, tweet)) return false;
+            }
+            return true;
+        }
+        if (criteria.checkedAuthors.contains(tweet.author) ||
+            (tweet.author.isEmpty() && criteria.checkedAuthors.contains("Unknown"))) {
+            return true;
+        }
+        for (const QString& reqSonic : criteria.checkedSonicTags) {
+            if (tweet.sonicTags.contains(reqSonic, Qt::CaseInsensitive)) return true;
+        }
+        for (const QString& reqTechnique : criteria.checkedTechniqueTags) {
+            if (tweet.techniqueTags.contains(reqTechnique, Qt::CaseInsensitive)) return true;
+        }
+        for (int i = 0; i < criteria.checkedUgens.size(); ++i) {
+            if (ugenFound(i, tweet)) return true;
+        }
+        return false;
+    };
+
+    QVector<const TweetData*> results;
+    for (const auto& tweet : allTweets) {
+        if (passes(tweet)) results.append(&tweet);
+    }
+    return results;
+}
+
+template <typename Fn>
+qint64 bestOf(Fn&& fn)
+{
+    qint64 best = std::numeric_limits<qint64>::max();
+    for (int run = 0; run < kRuns; ++run) best = qMin(best, BenchmarkCorpus::elapsedNanos(fn));
+    return best;
+}
+
+bool runLogic(const TweetRepository& repository, TweetFilterEngine& engine, bool useAndLogic)
+{
+    FilterCriteria criteria = checkedFacets(useAndLogic);
+    criteria.repositoryVersion = repository.version();
+    const QVector<TweetData>& allTweets = repository.getAllTweets();
+
+    QVector<const TweetData*> engineResults;
+    QVector<const TweetData*> perRowResults;
+    const qint64 engineNanos = bestOf([&] {
+        engine.clearPreviousResult(); // Otherwise every run after the first only re-checks the last result
+        engineResults = engine.filterTweets(allTweets, repository.facetIndex(), repository.trigramIndex(),
+                                            repository.searchKeys(), criteria);
+    });
+    const qint64 perRowNanos = bestOf([&] { perRowResults = perRowFilter(allTweets, criteria); });
+    if (engineResults != perRowResults) {
+        std::fprintf(stderr, "%s: engine and per-row results differ (%lld vs %lld rows)\n", useAndLogic ? "AND" : "OR",
+                     static_cast<long long>(engineResults.size()), static_cast<long long>(perRowResults.size()));
+        return false;
+    }
+    std::printf("  %-4s %9lld %14.3f ms %14.3f ms %9.1fx\n", useAndLogic ? "AND" : "OR",
+                static_cast<long long>(engineResults.size()), engineNanos / 1e6, perRowNanos / 1e6,
+                engineNanos > 0 ? double(perRowNanos) / engineNanos : 0.0);
+    return true;
+}
+
+bool runSize(int corpusSize)
+{
+    QTemporaryDir directory;
+    TweetRepository repository;
+    if (!directory.isValid() || !BenchmarkCorpus::loadRepository(repository, BenchmarkCorpus::tweets(corpusSize), directory.path())) {
+        std::fprintf(stderr, "Could not load a corpus of %d tweets\n", corpusSize);
+        return false;
+    }
+    TweetFilterEngine engine;
+    engine.setCacheCapacity(0); // Time the evaluation, not the result cache
+    std::printf("%d tweets, %d facet values checked\n", corpusSize, checkedCount(checkedFacets(true)));
+    std::printf("  %-4s %9s %17s %17s %10s\n", "", "matches", "filterTweets", "per-row loop", "speedup");
+    bool ok = runLogic(repository, engine, true);
+    ok = runLogic(repository, engine, false) && ok;
+    return ok;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    BenchmarkCorpus::silenceInfoLogging();
+
+    bool ok = true;
+    const QVector<int> sizes = BenchmarkCorpus::corpusSizes(app.arguments(), { 10000, 100000, 1000000 });
+    for (int size : sizes) ok = runSize(size) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+// Times SCCodePrettyPrinter on generated SuperCollider code of doubling size and reports the
+// cost per input byte; flat ns/byte across sizes means formatting stays linear.
+//
+//   bench_prettyprinter [bytes...]     (default: 1 KiB doubling to 512 KiB)
+
+#include "benchmarkcorpus.h"
+#include "sccodeprettyprinter.h"
+#include <QCoreApplication>
+#include <cstdio>
+#include <limits>
+
+namespace {
+const int kRuns = 5; // Best of
+
+// One statement per template, covering the node types with their own handlers: function and
+// code blocks, parameter lists, calls with and without receivers, binary expressions,
+// collections and arithmetic series. %1 varies the numbers so no two statements are identical.
+const char* const kStatements[] = {
+    "{ |freq = %1, amp = 0.1| SinOsc.ar(freq * [1, 1.01], 0, amp) * LFNoise1.kr(0.%1).range(0.2, 1) }.play",
+    "x = Array.fill(8, { |i| (i + 1) * %1 }).collect({ |f| Pulse.ar(f, 0.3) }).sum * 0.05",
+    "Ndef(\\n%1, { Splay.ar(RLPF.ar(Saw.ar((1..5) * %1), LFTri.kr(0.1).exprange(200, 4000), 0.2)) })",
+    "(\n var env = Env.perc(0.01, %1 / 100);\n EnvGen.kr(env, doneAction: 2) * WhiteNoise.ar(0.1)\n)",
+    "Pbind(\\degree, Pseq([0, 2, 4, 7], inf), \\dur, 0.%1, \\amp, Pwhite(0.1, 0.3)).play",
+    "r = Routine({ loop { (%1 + 10.rand).postln; 0.25.wait } })",
+};
+
+QString generatedCode(qsizetype targetBytes)
+{
+    const int statementCount = int(sizeof(kStatements) / sizeof(kStatements[0]));
+    QString code;
+    code.reserve(targetBytes + 256);
+    for (int i = 0; code.size() < targetBytes; ++i) {
+        code += QString::fromLatin1(kStatements[i % statementCount]).arg(100 + i % 900);
+        code += QStringLiteral(";\n");
+    }
+    return code;
+}
+
+template <typename Fn>
+qint64 bestOf(Fn&& fn)
+{
+    qint64 best = std::numeric_limits<qint64>::max();
+    for (int run = 0; run < kRuns; ++run) best = qMin(best, BenchmarkCorpus::elapsedNanos(fn));
+    return best;
+}
+
+QVector<int> defaultSizes()
+{
+    QVector<int> sizes;
+    for (int bytes = 1024; bytes <= 512 * 1024; bytes *= 2) sizes.append(bytes);
+    return sizes;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    BenchmarkCorpus::silenceInfoLogging();
+
+    SCCodePrettyPrinter printer;
+    if (!printer.initialize()) {
+        std::fprintf(stderr, "Could not initialize the Tree-sitter parser\n");
+        return 1;
+    }
+    printer.setTreeCacheCapacity(0); // Every parse below must really parse
+
+    std::printf("%10s %8s %14s %14s %12s\n", "bytes", "errors", "parse ns/B", "format ns/B", "output B");
+    for (int size : BenchmarkCorpus::corpusSizes(app.arguments(), defaultSizes())) {
+        const QString code = generatedCode(size);
+        bool parsed = true;
+        const qint64 parseNanos = bestOf([&] { parsed = printer.parse(code) && parsed; });
+        if (!parsed) {
+            std::fprintf(stderr, "Parsing %d bytes failed\n", size);
+            return 1;
+        }
+        QString formatted;
+        const qint64 formatNanos = bestOf([&] { formatted = printer.formatCurrentTree(); });
+
+        const double bytes = double(printer.currentCodeUtf8().size());
+        std::printf("%10lld %8lld %14.1f %14.1f %12lld\n", static_cast<long long>(bytes),
+                    static_cast<long long>(printer.syntaxErrors().size()), parseNanos / bytes,
+                    formatNanos / bytes, static_cast<long long>(formatted.toUtf8().size()));
+    }
+    return 0;
+}
@@ -0,0 +1,154 @@
+// Times TweetRepository's id-indexed lookup and mutations against the linear scans they
+// replaced, at increasing collection sizes.
+//
+//   bench_tweetrepository [size...]     (default: 10000 100000 1000000)
+
+#include "benchmarkcorpus.h"
+#include "tweetrepository.h"
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <cstdio>
+
+namespace {
+const int kLookups = 1000;
+// Under the journal's compaction threshold (256 records) together, and far too few deletes
+// for tombstone compaction, so no background save lands inside a timed loop
+const int kMutations = 80;
+
+// The pre-index implementations, minus deriving and journaling the tweet, which the indexed
+// versions do on top of their lookup; the speedups below therefore understate the change.
+const TweetData* linearFind(const QVector<TweetData>& tweets, const QString& id)
+{
+    for (const TweetData& tweet : tweets) {
+        if (tweet.id == id) return &tweet;
+    }
+    return nullptr;
+}
+
+bool linearAdd(QVector<TweetData>& tweets, const TweetData& newTweet)
+{
+    if (linearFind(tweets, newTweet.id)) return false;
+    tweets.append(newTweet);
+    return true;
+}
+
+bool linearUpdate(QVector<TweetData>& tweets, const TweetData& updatedTweet)
+{
+    for (TweetData& tweet : tweets) {
+        if (tweet.id == updatedTweet.id) {
+            tweet = updatedTweet;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool linearDelete(QVector<TweetData>& tweets, const QString& id)
+{
+    for (int i = 0; i < tweets.size(); ++i) {
+        if (tweets.at(i).id == id) {
+            tweets.remove(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Spread over the whole collection, so the linear scans pay their average cost
+QStringList spreadIds(int corpusSize, int count, int offset)
+{
+    QStringList ids;
+    for (int i = 0; i < count; ++i) {
+        ids.append(BenchmarkCorpus::tweetId(int((qint64(i) * corpusSize) / count + offset) % corpusSize));
+    }
+    return ids;
+}
+
+void report(const char* operation, qint64 indexedNanos, qint64 linearNanos, int operations)
+{
+    const double indexed = double(indexedNanos) / operations;
+    const double linear = double(linearNanos) / operations;
+    std::printf("  %-8s %12.0f ns/op %14.0f ns/op %9.1fx\n", operation, indexed, linear,
+                indexed > 0 ? linear / indexed : 0.0);
+}
+
+bool runSize(int corpusSize)
+{
+    QTemporaryDir directory;
+    TweetRepository repository;
+    if (!directory.isValid() || !BenchmarkCorpus::loadRepository(repository, BenchmarkCorpus::tweets(corpusSize), directory.path())) {
+        std::fprintf(stderr, "Could not load a corpus of %d tweets\n", corpusSize);
+        return false;
+    }
+    // Shares the repository's strings; detached now so the copy is not charged to the first mutation
+    QVector<TweetData> linear = repository.getAllTweets();
+    linear.detach();
+
+    const QStringList lookupIds = spreadIds(corpusSize, kLookups, 0);
+    const QStringList updateIds = spreadIds(corpusSize, kMutations, 1);
+    const QStringList deleteIds = spreadIds(corpusSize, kMutations, 2);
+    QVector<TweetData> additions;
+    QVector<TweetData> updates;
+    for (int i = 0; i < kMutations; ++i) {
+        additions.append(BenchmarkCorpus::tweet(corpusSize + i));
+        TweetData update = *repository.findTweetById(updateIds.at(i));
+        update.description += QStringLiteral(" (edited)");
+        updates.append(update);
+    }
+
+    int found = 0;
+    const qint64 indexedFind = BenchmarkCorpus::elapsedNanos([&] {
+        for (const QString& id : lookupIds) found += repository.findTweetById(id) != nullptr;
+    });
+    const qint64 linearFindNanos = BenchmarkCorpus::elapsedNanos([&] {
+        for (const QString& id : lookupIds) found += linearFind(linear, id) != nullptr;
+    });
+
+    int changed = 0;
+    const qint64 indexedAdd = BenchmarkCorpus::elapsedNanos([&] {
+        for (const TweetData& tweet : additions) changed += repository.addTweet(tweet);
+    });
+    const qint64 linearAddNanos = BenchmarkCorpus::elapsedNanos([&] {
+        for (const TweetData& tweet : additions) changed += linearAdd(linear, tweet);
+    });
+    const qint64 indexedUpdate = BenchmarkCorpus::elapsedNanos([&] {
+        for (const TweetData& tweet : updates) changed += repository.updateTweet(tweet);
+    });
+    const qint64 linearUpdateNanos = BenchmarkCorpus::elapsedNanos([&] {
+        for (const TweetData& tweet : updates) changed += linearUpdate(linear, tweet);
+    });
+    const qint64 indexedDelete = BenchmarkCorpus::elapsedNanos([&] {
+        for (const QString& id : deleteIds) changed += repository.deleteTweet(id);
+    });
+    const qint64 linearDeleteNanos = BenchmarkCorpus::elapsedNanos([&] {
+        for (const QString& id : deleteIds) changed += linearDelete(linear, id);
+    });
+    repository.waitForPendingSave();
+
+    if (found != 2 * kLookups || changed != 6 * kMutations) {
+        std::fprintf(stderr, "Unexpected results at %d tweets (found %d, changed %d)\n", corpusSize, found, changed);
+        return false;
+    }
+
+    std::printf("%d tweets\n", corpusSize);
+    std::printf("  %-8s %18s %20s %10s\n", "", "indexed", "linear scan", "speedup");
+    report("find", indexedFind, linearFindNanos, kLookups);
+    report("add", indexedAdd, linearAddNanos, kMutations);
+    report("update", indexedUpdate, linearUpdateNanos, kMutations);
+    report("delete", indexedDelete, linearDeleteNanos, kMutations);
+    return true;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    BenchmarkCorpus::silenceInfoLogging();
+
+    bool ok = true;
+    const QVector<int> sizes = BenchmarkCorpus::corpusSizes(app.arguments(), { 10000, 100000, 1000000 });
+    for (int size : sizes) {
+        ok = runSize(qMax(size, kLookups)) && ok; // spreadIds needs distinct probes
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+#include "benchmarkcorpus.h"
+#include "tweetrepository.h"
+#include "tweetjournal.h"
+#include <QDir>
+#include <QFile>
+#include <QLoggingCategory>
+
+namespace BenchmarkCorpus {
+
+namespace {
+const char* const kUgenNames[UgenCount] = {
+    "SinOsc", "Saw", "Pulse", "LFNoise0", "LFNoise1", "LFSaw", "LFTri", "VarSaw", "Blip", "Formant",
+    "RLPF", "RHPF", "BPF", "LPF", "HPF", "Ringz", "Klank", "CombN", "AllpassN", "FreeVerb",
+    "GVerb", "Pan2", "Splay", "Impulse", "Dust", "WhiteNoise", "PinkNoise", "Decay", "PMOsc", "Latch"
+};
+
+// Cheap integer hash (the splitmix32 finaliser); spreads consecutive indexes over the pools
+quint32 mix(quint32 x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+// Two distinct pool entries; a pair of equal tags would just read as one
+QStringList pickTwo(quint32 hash, int poolSize, QString (*name)(int))
+{
+    const int first = int(hash % quint32(poolSize));
+    const int second = int((hash / quint32(poolSize)) % quint32(poolSize));
+    if (first == second) return { name(first) };
+    return { name(first), name(second) };
+}
+}
+
+QString authorName(int index) { return QString("composer%1").arg(index); }
+QString sonicTagName(int index) { return QString("sonic%1").arg(index); }
+QString techniqueTagName(int index) { return QString("technique%1").arg(index); }
+QString ugenName(int index) { return QString::fromLatin1(kUgenNames[index % UgenCount]); }
+
+QString tweetId(int index)
+{
+    return QString("bench%1").arg(index, 7, 10, QLatin1Char('0')); // Zero-padded: the load sorts by id
+}
+
+static QString genericTagName(int index) { return QString("tag%1").arg(index); }
+
+TweetData tweet(int index)
+{
+    const quint32 hash = mix(quint32(index));
+    const quint32 hash2 = mix(hash);
+    TweetData td;
+    td.id = tweetId(index);
+    td.author = authorName(int(hash % AuthorCount));
+    td.sourceUrl = QString("https://example.org/sctweets/%1").arg(index);
+    td.description = QString("Synthetic benchmark tweet %1").arg(index);
+    td.publicationDate = QString("%1-%2-%3").arg(2009 + int(hash2 % 15))
+                             .arg(1 + int((hash2 >> 4) % 12), 2, 10, QLatin1Char('0'))
+                             .arg(1 + int((hash2 >> 8) % 28), 2, 10, QLatin1Char('0'));
+    td.sonicTags = pickTwo(hash >> 9, SonicTagCount, sonicTagName);
+    td.techniqueTags = pickTwo(hash2 >> 12, TechniqueTagCount, techniqueTagName);
+    td.genericTags = { genericTagName(int((hash2 >> 20) % GenericTagCount)) };
+    td.originalCode = QString("{ %1.ar(%4 * %5) * %2.kr(%6) + %3.ar(0.1) }.play // %7")
+                          .arg(ugenName(int(hash % UgenCount)), ugenName(int((hash >> 5) % UgenCount)),
+                               ugenName(int((hash2 >> 3) % UgenCount)))
+                          .arg(40 + int(hash2 % 400))
+                          .arg(1 + int((hash >> 3) % 4))
+                          .arg(0.1 + double(hash2 % 90) / 10.0)
+                          .arg(index);
+    return td;
+}
+
+QVector<TweetData> tweets(int count)
+{
+    QVector<TweetData> result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) result.append(tweet(i));
+    return result;
+}
+
+bool loadRepository(TweetRepository& repository, const QVector<TweetData>& tweets, const QString& directory)
+{
+    const QString path = QDir(directory).filePath("bench_tweets.json");
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    const QByteArray json = TweetJournal::encodeCorpus(tweets);
+    if (file.write(json) != json.size()) return false;
+    file.close();
+    return repository.loadTweets(path) && repository.waitForPendingLoad();
+}
+
+QVector<int> corpusSizes(const QStringList& arguments, const QVector<int>& defaults)
+{
+    QVector<int> sizes;
+    for (int i = 1; i < arguments.size(); ++i) {
+        bool ok = false;
+        const int size = arguments.at(i).toInt(&ok);
+        if (ok && size > 0) sizes.append(size);
+    }
+    return sizes.isEmpty() ? defaults : sizes;
+}
+
+void silenceInfoLogging()
+{
+    QLoggingCategory::setFilterRules(QStringLiteral("default.debug=false\ndefault.info=false"));
+}
+
+} // namespace BenchmarkCorpus
@@ -0,0 +1,51 @@
+#ifndef BENCHMARKCORPUS_H
+#define BENCHMARKCORPUS_H
+
+#include "tweetdata.h"
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QVector>
+
+class TweetRepository;
+
+// Synthetic tweet collections for the benchmark executables. Tweet i is always the same, so
+// runs at different sizes (and on different machines) measure the same data; authors, tags
+// and UGens come from fixed pools, so every value used by a benchmark exists at every size.
+namespace BenchmarkCorpus {
+
+const int AuthorCount = 500;
+const int SonicTagCount = 40;
+const int TechniqueTagCount = 40;
+const int GenericTagCount = 60;
+const int UgenCount = 30;
+
+QString authorName(int index);
+QString sonicTagName(int index);
+QString techniqueTagName(int index);
+QString ugenName(int index); // Real UGen class names, so extraction finds them in the code
+
+QString tweetId(int index);
+TweetData tweet(int index);
+QVector<TweetData> tweets(int count);
+
+// Writes tweets as a tweet file in directory and loads it, so the repository builds its
+// indexes exactly as it does for a real collection
+bool loadRepository(TweetRepository& repository, const QVector<TweetData>& tweets, const QString& directory);
+
+// Positional integer arguments replace the default corpus sizes
+QVector<int> corpusSizes(const QStringList& arguments, const QVector<int>& defaults);
+
+void silenceInfoLogging(); // The repository logs every add/update/delete
+
+template <typename Fn>
+qint64 elapsedNanos(Fn&& fn)
+{
+    QElapsedTimer timer;
+    timer.start();
+    fn();
+    return timer.nsecsElapsed();
+}
+
+} // namespace BenchmarkCorpus
+
+#endif // BENCHMARKCORPUS_H
@@ -0,0 +1,131 @@
+#include "facetindex.h"
+#include "symboltable.h"
+#include <QVarLengthArray>
+
+namespace {
+int kindIndex(FacetKind kind) { return static_cast<int>(kind); }
+}
+
+void FacetIndex::clear()
+{
+    for (auto& counts : m_counts) counts.clear();
+    for (auto& postings : m_postings) postings.clear();
+    m_liveRows = TweetBitmap();
+}
+
+void FacetIndex::addTweet(int row, const TweetData& tweet)
+{
+    adjust(row, tweet, +1);
+}
+
+void FacetIndex::removeTweet(int row, const TweetData& tweet)
+{
+    adjust(row, tweet, -1);
+}
+
+void FacetIndex::adjust(int row, const TweetData& tweet, int delta)
+{
+    if (tweet.isDeleted()) return;
+
+    auto bump = [row, delta, this](FacetKind kind, SymbolId value) {
+        QHash<SymbolId, int>& counts = m_counts[kindIndex(kind)];
+        QHash<SymbolId, TweetBitmap>& postings = m_postings[kindIndex(kind)];
+        auto it = counts.find(value);
+        if (it == counts.end()) {
+            if (delta > 0) {
+                counts.insert(value, delta);
+                postings[value].set(row);
+            }
+            return;
+        }
+        it.value() += delta;
+        if (it.value() <= 0) { // Values nobody uses disappear from the panel
+            counts.erase(it);
+            postings.remove(value);
+        } else if (delta > 0) {
+            postings[value].set(row);
+        } else {
+            postings[value].reset(row);
+        }
+    };
+
+    if (delta > 0) m_liveRows.set(row);
+    else m_liveRows.reset(row);
+
+    // Ids come from the table rather than per-tweet copies; the lookup only folds and hashes a few
+    // short strings, and happens once per changed row
+    const SymbolTable& symbols = SymbolTable::instance();
+    auto bumpValues = [&](FacetKind kind, const QStringList& values) {
+        QVarLengthArray<SymbolId, 8> seen;
+        for (const QString& value : values) {
+            const SymbolId id = symbols.lookup(value);
+            if (id == InvalidSymbolId || seen.contains(id)) continue; // "Drone" and "drone" are one facet value
+            seen.append(id);
+            bump(kind, id);
+        }
+    };
+    bump(FacetKind::Author, tweet.authorId);
+    bumpValues(FacetKind::SonicTag, tweet.sonicTags);
+    bumpValues(FacetKind::TechniqueTag, tweet.techniqueTags);
+    bumpValues(FacetKind::GenericTag, tweet.genericTags);
+    bumpValues(FacetKind::Ugen, tweet.ugens);
+}
+
+int FacetIndex::count(FacetKind kind, SymbolId value) const
+{
+    return m_counts[kindIndex(kind)].value(value, 0);
+}
+
+const QHash<SymbolId, int>& FacetIndex::counts(FacetKind kind) const
+{
+    return m_counts[kindIndex(kind)];
+}
+
+QHash<QString, int> FacetIndex::countsByText(FacetKind kind) const
+{
+    const QHash<SymbolId, int>& counts = m_counts[kindIndex(kind)];
+    const SymbolTable& symbols = SymbolTable::instance();
+    QHash<QString, int> result;
+    result.reserve(counts.size());
+    for (auto it = counts.constBegin(); it != counts.constEnd(); ++it) {
+        result.insert(symbols.text(it.key()), it.value());
+    }
+    return result;
+}
+
+QHash<QString, int> FacetIndex::countsWithin(FacetKind kind, const TweetBitmap& rows) const
+{
+    const QHash<SymbolId, TweetBitmap>& postings = m_postings[kindIndex(kind)];
+    const SymbolTable& symbols = SymbolTable::instance();
+    QHash<QString, int> result;
+    result.reserve(postings.size());
+    for (auto it = postings.constBegin(); it != postings.constEnd(); ++it) {
+        result.insert(symbols.text(it.key()), rows.intersectionCount(it.value()));
+    }
+    return result;
+}
+
+QSet<QString> FacetIndex::values(FacetKind kind) const
+{
+    const QHash<SymbolId, int>& counts = m_counts[kindIndex(kind)];
+    const SymbolTable& symbols = SymbolTable::instance();
+    QSet<QString> result;
+    result.reserve(counts.size());
+    for (auto it = counts.constBegin(); it != counts.constEnd(); ++it) {
+        result.insert(symbols.text(it.key()));
+    }
+    return result;
+}
+
+const TweetBitmap& FacetIndex::postings(FacetKind kind, SymbolId value) const
+{
+    static const TweetBitmap empty;
+    const QHash<SymbolId, TweetBitmap>& postings = m_postings[kindIndex(kind)];
+    auto it = postings.constFind(value);
+    return it != postings.constEnd() ? it.value() : empty;
+}
+
+const TweetBitmap& FacetIndex::liveRows() const
+{
+    return m_liveRows;
+}
@@ -0,0 +1,51 @@
+#ifndef FACETINDEX_H
+#define FACETINDEX_H
+
+#include "tweetdata.h"
+#include "tweetbitmap.h"
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+enum class FacetKind {
+    Author,
+    SonicTag,
+    TechniqueTag,
+    GenericTag,
+    Ugen
+};
+
+// Per-value reference counts and row postings for every filterable facet, owned by
+// TweetRepository and updated in O(values of the changed tweet) on each
+// add/update/delete, so the filter panel never has to rescan the corpus to list
+// values or show their counts, and TweetFilterEngine answers checkbox filters
+// with bitmap intersections and unions instead of a per-tweet scan.
+class FacetIndex
+{
+public:
+    static constexpr int KindCount = 5;
+
+    void clear();
+    // The tweet's values must already be interned; removeTweet needs the values it was added with
+    void addTweet(int row, const TweetData& tweet);
+    void removeTweet(int row, const TweetData& tweet);
+
+    int count(FacetKind kind, SymbolId value) const;
+    const QHash<SymbolId, int>& counts(FacetKind kind) const;
+    QHash<QString, int> countsByText(FacetKind kind) const; // Display spelling -> count
+    // Display spelling -> how many of rows carry it, zeros included; one popcount pass per value
+    QHash<QString, int> countsWithin(FacetKind kind, const TweetBitmap& rows) const;
+    QSet<QString> values(FacetKind kind) const;
+
+    const TweetBitmap& postings(FacetKind kind, SymbolId value) const; // Empty bitmap if unused
+    const TweetBitmap& liveRows() const; // Every row that is not a tombstone
+
+private:
+    void adjust(int row, const TweetData& tweet, int delta);
+
+    QHash<SymbolId, int> m_counts[KindCount];
+    QHash<SymbolId, TweetBitmap> m_postings[KindCount];
+    TweetBitmap m_liveRows;
+};
+
+#endif // FACETINDEX_H
@@ -4,7 +4,7 @@
 #include <QDebug>
 
 FavoritesManager::FavoritesManager(QSettings* settings, QObject *parent)
-    : QObject(parent), m_settings(settings)
+    : QObject(parent), m_settings(settings), m_version(0)
 {
     Q_ASSERT(m_settings != nullptr);
     loadFavorites();
@@ -15,6 +15,7 @@ void FavoritesManager::loadFavorites()
     if (!m_settings) return;
     QStringList favList = m_settings->value("favorites", QStringList()).toStringList();
     m_favoriteTweetIds = QSet<QString>(favList.begin(), favList.end());
+    ++m_version;
     qInfo() << "Loaded" << m_favoriteTweetIds.count() << "favorites from settings.";
 }
 
@@ -35,6 +36,7 @@ void FavoritesManager::addFavorite(const QString& tweetId)
 {
     if (!m_favoriteTweetIds.contains(tweetId)) {
         m_favoriteTweetIds.insert(tweetId);
+        ++m_version;
         saveFavorites();
         emit favoritesChanged();
     }
@@ -44,6 +46,7 @@ void FavoritesManager::removeFavorite(const QString& tweetId)
 {
     if (m_favoriteTweetIds.contains(tweetId)) {
         m_favoriteTweetIds.remove(tweetId);
+        ++m_version;
         saveFavorites();
         emit favoritesChanged();
     }
@@ -52,4 +55,9 @@ void FavoritesManager::removeFavorite(const QString& tweetId)
 const QSet<QString>& FavoritesManager::getFavoriteTweetIds() const
 {
     return m_favoriteTweetIds;
-}
\ No newline at end of file
+}
+
+quint64 FavoritesManager::version() const
+{
+    return m_version;
+}
@@ -20,6 +20,7 @@ public:
     void addFavorite(const QString& tweetId);
     void removeFavorite(const QString& tweetId);
     const QSet<QString>& getFavoriteTweetIds() const;
+    quint64 version() const; // Bumped whenever the favorite set changes
 
 signals:
     void favoritesChanged(); // Emitted when a favorite is added/removed
@@ -27,6 +28,7 @@ signals:
 private:
     QSettings* m_settings;
     QSet<QString> m_favoriteTweetIds;
+    quint64 m_version;
 };
 
 #endif // FAVORITESMANAGER_H
\ No newline at end of file
@@ -11,6 +11,7 @@
 FilterPanelWidget::FilterPanelWidget(QWidget *parent)
     : QWidget(parent),
       m_filterLogicToggle(nullptr),
+      m_verifyUgensToggle(nullptr),
       m_favoriteFilterButton(nullptr),
       m_resetFiltersButton(nullptr)
 {
@@ -39,6 +40,11 @@ FilterPanelWidget::FilterPanelWidget(QWidget *parent)
     m_filterLogicToggle->setChecked(true); // Default to AND logic
     connect(m_filterLogicToggle, &QCheckBox::checkStateChanged, this, &FilterPanelWidget::onFilterControlChanged);
 
+    m_verifyUgensToggle = new QCheckBox("Verify UGens", buttonWidget);
+    m_verifyUgensToggle->setObjectName("VerifyUgensToggle");
+    m_verifyUgensToggle->setToolTip("Also confirm checked UGens by scanning each tweet's code.\nSlower on large collections; off uses the precomputed UGen lists.");
+    connect(m_verifyUgensToggle, &QCheckBox::checkStateChanged, this, &FilterPanelWidget::onFilterControlChanged);
+
     m_favoriteFilterButton = new QPushButton("Favorites Only", buttonWidget);
     m_favoriteFilterButton->setCheckable(true);
     connect(m_favoriteFilterButton, &QPushButton::toggled, this, &FilterPanelWidget::onFilterControlChanged);
@@ -48,6 +54,7 @@ FilterPanelWidget::FilterPanelWidget(QWidget *parent)
     connect(m_resetFiltersButton, &QPushButton::clicked, this, &FilterPanelWidget::resetAllFilters);
 
     buttonLayout->addWidget(m_filterLogicToggle);
+    buttonLayout->addWidget(m_verifyUgensToggle);
     buttonLayout->addStretch(1);
     buttonLayout->addWidget(m_favoriteFilterButton);
     buttonLayout->addWidget(m_resetFiltersButton);
@@ -58,10 +65,10 @@ FilterPanelWidget::FilterPanelWidget(QWidget *parent)
 }
 
 void FilterPanelWidget::populateFilters(
-    const QSet<QString>& authors,
-    const QSet<QString>& sonicTags,
-    const QSet<QString>& techniqueTags,
-    const QSet<QString>& ugens)
+    const QHash<QString, int>& authors,
+    const QHash<QString, int>& sonicTags,
+    const QHash<QString, int>& techniqueTags,
+    const QHash<QString, int>& ugens)
 {
     // Clear previous groups if any (excluding the button bar)
     // This is a bit crude; a more robust way might involve storing group boxes and deleting them.
@@ -91,10 +98,10 @@ void FilterPanelWidget::populateFilters(
 void FilterPanelWidget::createCheckboxGroup(
     QVBoxLayout* mainLayout,
     const QString& title,
-    const QSet<QString>& items,
+    const QHash<QString, int>& itemCounts,
     QList<QCheckBox*>& checkboxList)
 {
-    if (items.isEmpty()) {
+    if (itemCounts.isEmpty()) {
         qDebug() << "No items found for filter group:" << title;
         return;
     }
@@ -103,11 +110,13 @@ void FilterPanelWidget::createCheckboxGroup(
     groupLayout->setContentsMargins(4, 4, 4, 4);
     groupLayout->setSpacing(4);
 
-    QStringList sortedItems = items.values();
+    QStringList sortedItems = itemCounts.keys();
     sortedItems.sort(Qt::CaseInsensitive);
 
     for (const QString& item : sortedItems) {
-        QCheckBox *checkbox = new QCheckBox(item);
+        QCheckBox *checkbox = new QCheckBox(QString("%1 (%2)").arg(item).arg(itemCounts.value(item)));
+        checkbox->setProperty("filterValue", item); // The label carries the count; filters need the raw value
+        checkbox->setProperty("facetCount", itemCounts.value(item));
         checkbox->setObjectName("FilterCheck_" + title.simplified().replace(" ", "_") + "_" + item);
         connect(checkbox, &QCheckBox::checkStateChanged, this, &FilterPanelWidget::onFilterControlChanged);
         groupLayout->addWidget(checkbox);
@@ -118,6 +127,35 @@ void FilterPanelWidget::createCheckboxGroup(
 }
 
 
+void FilterPanelWidget::updateFacetCounts(
+    const QHash<QString, int>& authors,
+    const QHash<QString, int>& sonicTags,
+    const QHash<QString, int>& techniqueTags,
+    const QHash<QString, int>& ugens)
+{
+    applyCounts(m_authorCheckboxes, authors);
+    applyCounts(m_sonicCheckboxes, sonicTags);
+    applyCounts(m_techniqueCheckboxes, techniqueTags);
+    applyCounts(m_ugenCheckboxes, ugens);
+}
+
+void FilterPanelWidget::applyCounts(const QList<QCheckBox*>& checkboxList, const QHash<QString, int>& counts)
+{
+    for (QCheckBox* checkbox : checkboxList) {
+        const QString value = checkbox->property("filterValue").toString();
+        const int count = counts.value(value, 0);
+        // Only touch checkboxes whose count moved: relabelling hundreds of them relayouts the panel
+        if (checkbox->property("facetCount").toInt() == count) continue;
+        checkbox->setProperty("facetCount", count);
+        checkbox->setText(QString("%1 (%2)").arg(value).arg(count));
+        // Dimmed, not disabled: a checked value the results no longer carry must stay uncheckable
+        QPalette palette = checkbox->palette();
+        palette.setColor(QPalette::WindowText, this->palette().color(
+            count == 0 ? QPalette::Disabled : QPalette::Active, QPalette::WindowText));
+        checkbox->setPalette(palette);
+    }
+}
+
 void FilterPanelWidget::onFilterControlChanged()
 {
     emit filtersChanged();
@@ -127,9 +165,11 @@ void FilterPanelWidget::resetAllFilters()
 {
     // Block signals to prevent multiple emissions of filtersChanged
     bool logicBlocked = m_filterLogicToggle->signalsBlocked();
+    bool verifyBlocked = m_verifyUgensToggle->signalsBlocked();
     bool favBlocked = m_favoriteFilterButton->signalsBlocked();
 
     m_filterLogicToggle->blockSignals(true);
+    m_verifyUgensToggle->blockSignals(true);
     m_favoriteFilterButton->blockSignals(true);
 
     QList<QList<QCheckBox*>> allCheckboxLists = {
@@ -145,40 +185,44 @@ void FilterPanelWidget::resetAllFilters()
     }
 
     m_filterLogicToggle->setChecked(true); // Default to AND
+    m_verifyUgensToggle->setChecked(false);
     m_favoriteFilterButton->setChecked(false);
 
     m_filterLogicToggle->blockSignals(logicBlocked);
+    m_verifyUgensToggle->blockSignals(verifyBlocked);
     m_favoriteFilterButton->blockSignals(favBlocked);
 
     emit filtersChanged(); // Emit signal once after all changes
     qInfo() << "Filters reset in panel.";
 }
 
-QStringList FilterPanelWidget::getCheckedAuthors() const {
+QStringList FilterPanelWidget::checkedValues(const QList<QCheckBox*>& checkboxList) {
     QStringList checked;
-    for (const QCheckBox* cb : m_authorCheckboxes) { if (cb->isChecked()) checked.append(cb->text()); }
+    for (const QCheckBox* cb : checkboxList) { if (cb->isChecked()) checked.append(cb->property("filterValue").toString()); }
     return checked;
 }
+
+QStringList FilterPanelWidget::getCheckedAuthors() const {
+    return checkedValues(m_authorCheckboxes);
+}
 QStringList FilterPanelWidget::getCheckedSonicTags() const {
-    QStringList checked;
-    for (const QCheckBox* cb : m_sonicCheckboxes) { if (cb->isChecked()) checked.append(cb->text()); }
-    return checked;
+    return checkedValues(m_sonicCheckboxes);
 }
 QStringList FilterPanelWidget::getCheckedTechniqueTags() const {
-    QStringList checked;
-    for (const QCheckBox* cb : m_techniqueCheckboxes) { if (cb->isChecked()) checked.append(cb->text()); }
-    return checked;
+    return checkedValues(m_techniqueCheckboxes);
 }
 QStringList FilterPanelWidget::getCheckedUgens() const {
-    QStringList checked;
-    for (const QCheckBox* cb : m_ugenCheckboxes) { if (cb->isChecked()) checked.append(cb->text()); }
-    return checked;
+    return checkedValues(m_ugenCheckboxes);
 }
 
 bool FilterPanelWidget::isMatchAllLogic() const {
     return m_filterLogicToggle ? m_filterLogicToggle->isChecked() : true;
 }
 
+bool FilterPanelWidget::isVerifyUgensInSource() const {
+    return m_verifyUgensToggle ? m_verifyUgensToggle->isChecked() : false;
+}
+
 bool FilterPanelWidget::isFavoritesFilterActive() const {
     return m_favoriteFilterButton ? m_favoriteFilterButton->isChecked() : false;
 }
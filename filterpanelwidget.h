@@ -3,7 +3,7 @@
 
 #include <QWidget>
 #include <QList> // For QList<QCheckBox*>
-#include <QSet>  // For QSet<QString>
+#include <QHash> // For per-value counts
 
 QT_BEGIN_NAMESPACE
 class QCheckBox;
@@ -19,11 +19,21 @@ class FilterPanelWidget : public QWidget
 public:
     explicit FilterPanelWidget(QWidget *parent = nullptr);
 
+    // Each map holds value -> number of tweets carrying it; checkboxes read "SinOsc (412)"
     void populateFilters(
-        const QSet<QString>& authors,
-        const QSet<QString>& sonicTags,
-        const QSet<QString>& techniqueTags,
-        const QSet<QString>& ugens
+        const QHash<QString, int>& authors,
+        const QHash<QString, int>& sonicTags,
+        const QHash<QString, int>& techniqueTags,
+        const QHash<QString, int>& ugens
+    );
+
+    // Relabels existing checkboxes with how many of the current results carry each value;
+    // values missing from a map count as zero and are dimmed
+    void updateFacetCounts(
+        const QHash<QString, int>& authors,
+        const QHash<QString, int>& sonicTags,
+        const QHash<QString, int>& techniqueTags,
+        const QHash<QString, int>& ugens
     );
 
     // Methods to get current filter states
@@ -32,6 +42,7 @@ public:
     QStringList getCheckedTechniqueTags() const;
     QStringList getCheckedUgens() const;
     bool isMatchAllLogic() const;
+    bool isVerifyUgensInSource() const;
     bool isFavoritesFilterActive() const;
     void setFavoritesFilterActive(bool active);
 
@@ -49,15 +60,18 @@ private:
     void createCheckboxGroup(
         QVBoxLayout* mainLayout,
         const QString& title,
-        const QSet<QString>& items,
+        const QHash<QString, int>& itemCounts,
         QList<QCheckBox*>& checkboxList
     );
+    static QStringList checkedValues(const QList<QCheckBox*>& checkboxList);
+    void applyCounts(const QList<QCheckBox*>& checkboxList, const QHash<QString, int>& counts);
 
     QVBoxLayout* m_mainLayout; // Main layout for the scrollable widget content
     QScrollArea* m_scrollArea;
     QWidget* m_scrollWidget; // Widget inside scroll area
 
     QCheckBox* m_filterLogicToggle;    // "Match All" / "Match Any"
+    QCheckBox* m_verifyUgensToggle;    // Opt-in regex check of checked UGens against the code
     QPushButton* m_favoriteFilterButton; // Toggle for favorites filter
     QPushButton* m_resetFiltersButton;
 
@@ -0,0 +1,85 @@
+#include "fuzzymatcher.h"
+
+namespace {
+const int kMaxPatternLength = 64; // One machine word of bit-parallel state
+}
+
+FuzzyMatcher::FuzzyMatcher(const QString& foldedPattern)
+    : m_length(qMin(int(foldedPattern.size()), kMaxPatternLength))
+{
+    m_asciiMasks.fill(0);
+    for (int i = 0; i < m_length; ++i) {
+        const char16_t c = foldedPattern.at(i).unicode();
+        const quint64 bit = quint64(1) << i;
+        if (c < 128) {
+            m_asciiMasks[c] |= bit;
+            continue;
+        }
+        bool found = false;
+        for (auto& entry : m_otherMasks) {
+            if (entry.first == c) { entry.second |= bit; found = true; break; }
+        }
+        if (!found) m_otherMasks.append(qMakePair(c, bit));
+    }
+}
+
+int FuzzyMatcher::maxDistance() const
+{
+    if (m_length <= 4) return 1;
+    if (m_length <= 8) return 2;
+    return 3;
+}
+
+quint64 FuzzyMatcher::peq(QChar c) const
+{
+    const char16_t u = c.unicode();
+    if (u < 128) return m_asciiMasks[u];
+    for (const auto& entry : m_otherMasks) {
+        if (entry.first == u) return entry.second;
+    }
+    return 0;
+}
+
+int FuzzyMatcher::substringDistance(QStringView foldedText, int cutoff) const
+{
+    return run<false>(foldedText, cutoff);
+}
+
+int FuzzyMatcher::editDistance(QStringView foldedText) const
+{
+    return run<true>(foldedText, -1);
+}
+
+template <bool Anchored>
+int FuzzyMatcher::run(QStringView text, int cutoff) const
+{
+    if (m_length == 0) return Anchored ? int(text.size()) : 0;
+
+    // Column state of the DP matrix as vertical +1/-1 delta bit vectors
+    const quint64 lastBit = quint64(1) << (m_length - 1);
+    quint64 pv = (m_length == kMaxPatternLength) ? ~quint64(0) : (lastBit << 1) - 1;
+    quint64 mv = 0;
+    int score = m_length;
+    int best = m_length;
+
+    for (QChar c : text) {
+        const quint64 eq = peq(c);
+        const quint64 xv = eq | mv;
+        const quint64 xh = (((eq & pv) + pv) ^ pv) | eq;
+        quint64 ph = mv | ~(xh | pv);
+        quint64 mh = pv & xh;
+        if (ph & lastBit) ++score;
+        else if (mh & lastBit) --score;
+        // Anchored: the top row counts text characters (global distance). Otherwise it stays
+        // zero, so a match may start anywhere in the text.
+        ph = Anchored ? (ph << 1) | 1 : ph << 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+        if (!Anchored && score < best) {
+            best = score;
+            if (best <= cutoff) break;
+        }
+    }
+    return Anchored ? score : best;
+}
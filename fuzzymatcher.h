@@ -0,0 +1,37 @@
+#ifndef FUZZYMATCHER_H
+#define FUZZYMATCHER_H
+
+#include <QString>
+#include <QStringView>
+#include <QVarLengthArray>
+#include <QPair>
+#include <array>
+
+// Bit-parallel approximate matcher (Myers' algorithm, Hyyrö's formulation) for one
+// case-folded pattern of up to 64 UTF-16 units; longer patterns are truncated. Each
+// text character costs a handful of word operations, so scoring every tweet id in a
+// large corpus on each keystroke stays within a few milliseconds.
+class FuzzyMatcher
+{
+public:
+    explicit FuzzyMatcher(const QString& foldedPattern);
+
+    int patternLength() const { return m_length; }
+    int maxDistance() const; // Typo budget that scales with the pattern length
+
+    // Smallest edit distance between the pattern and any substring of 'text', or
+    // patternLength() when nothing better exists. Stops early once 'cutoff' is reached.
+    int substringDistance(QStringView foldedText, int cutoff = 0) const;
+    int editDistance(QStringView foldedText) const; // Whole-string Levenshtein distance
+
+private:
+    quint64 peq(QChar c) const;
+    template <bool Anchored>
+    int run(QStringView text, int cutoff) const;
+
+    int m_length;
+    std::array<quint64, 128> m_asciiMasks;                   // Per-character match masks, ASCII
+    QVarLengthArray<QPair<char16_t, quint64>, 8> m_otherMasks; // Everything else, searched linearly
+};
+
+#endif // FUZZYMATCHER_H
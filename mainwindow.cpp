@@ -22,11 +22,14 @@
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QFormLayout> // For layout within groupbox
+#include <QThreadPool>
+#include <QtConcurrent> // Filtering runs on m_filterPool
 
 // --- Constructor ---
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , m_searchLineEdit(nullptr)
+    , m_sortComboBox(nullptr)
     , m_mainSplitter(nullptr)
     , m_filterPanelWidget(nullptr)
     , m_tweetListWidget(nullptr)
@@ -47,6 +50,8 @@ MainWindow::MainWindow(QWidget *parent)
     , m_tweetRepository(nullptr)
     , m_favoritesManager(nullptr)
     , m_tweetFilterEngine(nullptr)
+    , m_filterPool(nullptr)
+    , m_filterGeneration(0)
     , m_menuBar(nullptr)
     , m_fileMenu(nullptr)
     , m_editMenu(nullptr)
@@ -70,6 +75,12 @@ MainWindow::MainWindow(QWidget *parent)
     setupMenuBar(); 
     connectSignals();
 
+    // Load once the window is up, so the list can fill batch by batch instead of after a blank wait
+    QTimer::singleShot(0, this, &MainWindow::loadInitialTweets);
+}
+
+void MainWindow::loadInitialTweets()
+{
     QString userTweetPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
     if (!userTweetPath.isEmpty()) { 
         QDir appDataDir(userTweetPath);
@@ -82,25 +93,27 @@ MainWindow::MainWindow(QWidget *parent)
         QDir(QDir::homePath() + "/.SCTweetAlchemy").mkpath(".");
     }
 
-    QFile userFile(userTweetPath);
-    bool loadedSuccessfully = false;
-    if (userFile.exists()) {
+    // Asynchronous: the list fills batch by batch, and handleLoadFinished falls back to the resource
+    m_tweetListWidget->clear();
+    if (QFile::exists(userTweetPath)) {
         qInfo() << "Attempting to load tweets from user file:" << userTweetPath;
-        if (m_tweetRepository->loadTweets(userTweetPath)) {
-            loadedSuccessfully = true;
-        } else {
-            qWarning() << "Failed to load from user file, attempting resource.";
-        }
+        m_tweetRepository->loadTweets(userTweetPath);
+    } else {
+        qInfo() << "Attempting to load tweets from resource.";
+        m_tweetRepository->loadTweets();
     }
+    updateActionStates();
+}
 
-    if (!loadedSuccessfully) {
-        qInfo() << "Attempting to load tweets from resource.";
-        if (m_tweetRepository->loadTweets()) { 
-            loadedSuccessfully = true;
-        }
+void MainWindow::handleLoadFinished(const QString& filePath, bool ok)
+{
+    if (!ok && !filePath.startsWith(":/")) {
+        qWarning() << "Failed to load from user file, attempting resource.";
+        m_tweetListWidget->clear(); // Drops provisional rows from the failed attempt
+        if (m_tweetRepository->loadTweets()) return; // Back here when it finishes
     }
 
-    if (!loadedSuccessfully && m_tweetRepository->getAllTweets().isEmpty()) {
+    if (!ok && m_tweetRepository->tweetCount() == 0) {
         if(m_codeTextEdit) m_codeTextEdit->setPlaceholderText("No tweets found or failed to load all sources.");
         if(m_metadataTextEdit) m_metadataTextEdit->setPlaceholderText("");
         if(m_ndefCodeTextEdit) m_ndefCodeTextEdit->setPlaceholderText("Load tweets to see Ndef versions.");
@@ -114,11 +127,15 @@ MainWindow::MainWindow(QWidget *parent)
 
 // --- Destructor ---
 MainWindow::~MainWindow() {
+    ++m_filterGeneration; // Cancels whatever filter request is still running
+    if (m_filterPool) m_filterPool->waitForDone();
+    delete m_tweetFilterEngine;
     delete m_ndefGenerator; 
     if (m_tweetRepository) {
         if (!m_tweetRepository->getCurrentResourcePath().startsWith(":/")) {
              qInfo() << "Saving tweets on exit to:" << m_tweetRepository->getCurrentResourcePath();
              m_tweetRepository->saveTweetsToResource(); 
+             m_tweetRepository->waitForPendingSave(); // Writes off the GUI thread; don't exit mid-save
         } else {
              qInfo() << "Not saving on exit as current data source is a read-only resource:" << m_tweetRepository->getCurrentResourcePath();
         }
@@ -128,16 +145,35 @@ MainWindow::~MainWindow() {
 void MainWindow::setupModelsAndManagers()
 {
     m_tweetRepository = new TweetRepository(this);
+    // 0 = one thread per core; performers on small laptops can cap it to keep audio threads fed
+    m_tweetRepository->setMaxLoadThreads(m_settings->value("performance/maxLoadThreads", 0).toInt());
     m_favoritesManager = new FavoritesManager(m_settings, this);
     m_tweetFilterEngine = new TweetFilterEngine(); 
+    m_filterPool = new QThreadPool(this);
+    m_filterPool->setMaxThreadCount(1);
 }
 
 // --- Setup Overall UI Layout ---
 void MainWindow::setupUi()
 {
     m_searchLineEdit = new SearchLineEdit(this);
-    m_searchLineEdit->setPlaceholderText("Search Tweets (Global)...");
+    m_searchLineEdit->setPlaceholderText("Search code, descriptions, tags, authors...");
     m_searchLineEdit->setClearButtonEnabled(true);
+    m_searchLineEdit->setToolTip("Plain words search code, descriptions, tags and authors.\n"
+                                 "Queries: ugen:LocalIn AND (sonic:drone OR tech:fm) AND NOT author:earslap\n"
+                                 "Fields: ugen: sonic: tech: author: tag: id:  Prefix with EXPLAIN to see the plan.");
+
+    m_sortComboBox = new QComboBox(this);
+    m_sortComboBox->setObjectName("sortComboBox");
+    m_sortComboBox->addItem("Collection order", int(TweetSortMode::Collection));
+    m_sortComboBox->addItem("Relevance", int(TweetSortMode::Relevance));
+    m_sortComboBox->addItem("Shortest code", int(TweetSortMode::CodeLength));
+    m_sortComboBox->addItem("Fewest UGens", int(TweetSortMode::UgenCount));
+    m_sortComboBox->addItem("Author", int(TweetSortMode::Author));
+    m_sortComboBox->addItem("Newest", int(TweetSortMode::Date));
+    m_sortComboBox->setToolTip("Order of the tweet list. Relevance ranks plain search words found in the id first.");
+    const int savedSortIndex = m_sortComboBox->findData(m_settings->value("ui/sortMode", int(TweetSortMode::Collection)).toInt());
+    m_sortComboBox->setCurrentIndex(qMax(0, savedSortIndex));
 
     m_filterPanelWidget = new FilterPanelWidget(this);
 
@@ -160,8 +196,13 @@ void MainWindow::setupUi()
     m_mainSplitter->setStretchFactor(2, 3); 
     m_mainSplitter->setStretchFactor(3, 3); 
 
+    QHBoxLayout *searchLayout = new QHBoxLayout;
+    searchLayout->addWidget(m_searchLineEdit, 1);
+    searchLayout->addWidget(new QLabel("Sort:", this));
+    searchLayout->addWidget(m_sortComboBox);
+
     QVBoxLayout *centralLayout = new QVBoxLayout;
-    centralLayout->addWidget(m_searchLineEdit);
+    centralLayout->addLayout(searchLayout);
     centralLayout->addWidget(m_mainSplitter);
     QWidget *centralWidget = new QWidget(this);
     centralWidget->setLayout(centralLayout);
@@ -427,7 +468,12 @@ void MainWindow::connectSignals()
 {
     connect(m_tweetRepository, &TweetRepository::loadError, this, &MainWindow::handleRepositoryLoadError);
     connect(m_tweetRepository, &TweetRepository::tweetsLoaded, this, &MainWindow::handleTweetsLoaded);
+    connect(m_tweetRepository, &TweetRepository::loadProgress, this, &MainWindow::handleLoadProgress);
+    connect(m_tweetRepository, &TweetRepository::tweetsBatchLoaded, this, &MainWindow::handleTweetsBatchLoaded);
+    connect(m_tweetRepository, &TweetRepository::loadFinished, this, &MainWindow::handleLoadFinished);
     connect(m_tweetRepository, &TweetRepository::tweetsModified, this, &MainWindow::handleTweetsModified);
+    connect(m_tweetRepository, &TweetRepository::saveFinished, this, &MainWindow::handleSaveFinished);
+    connect(m_tweetRepository, &TweetRepository::saveFailed, this, &MainWindow::handleSaveFailed);
 
     connect(m_favoritesManager, &FavoritesManager::favoritesChanged, this, &MainWindow::handleFavoritesChanged);
 
@@ -436,6 +482,10 @@ void MainWindow::connectSignals()
     connect(m_tweetListWidget, &QListWidget::customContextMenuRequested, this, &MainWindow::onTweetListContextMenuRequested);
     
     connect(m_searchLineEdit, &QLineEdit::textChanged, this, &MainWindow::onSearchTextChanged);
+    connect(m_sortComboBox, &QComboBox::currentIndexChanged, this, [this]() {
+        m_settings->setValue("ui/sortMode", m_sortComboBox->currentData());
+        applyAllFilters();
+    });
     connect(m_searchLineEdit, &SearchLineEdit::navigationKeyPressed, this, &MainWindow::onSearchNavigateKey);
     
     connect(m_filterPanelWidget, &FilterPanelWidget::filtersChanged, this, &MainWindow::applyAllFilters);
@@ -481,18 +531,34 @@ void MainWindow::handleRepositoryLoadError(const QString& title, const QString&
 void MainWindow::handleTweetsLoaded(int count) {
     qInfo() << "MainWindow notified: " << count << "tweets loaded.";
     m_filterPanelWidget->populateFilters(
-        m_tweetRepository->getAllUniqueAuthors(),
-        m_tweetRepository->getAllUniqueSonicTags(),
-        m_tweetRepository->getAllUniqueTechniqueTags(),
-        m_tweetRepository->getAllUniqueUgens()
+        m_tweetRepository->getFacetCounts(FacetKind::Author),
+        m_tweetRepository->getFacetCounts(FacetKind::SonicTag),
+        m_tweetRepository->getFacetCounts(FacetKind::TechniqueTag),
+        m_tweetRepository->getFacetCounts(FacetKind::Ugen)
     );
-    applyAllFilters();
-    if (m_tweetListWidget->count() > 0) {
-       m_tweetListWidget->setCurrentRow(0);
-    }
+    applyAllFilters(); // The list fills, and selects its first row, when the results arrive
     updateActionStates();
 }
 
+void MainWindow::handleLoadProgress(qint64 bytesRead, qint64 totalBytes) {
+    if (totalBytes <= 0 || bytesRead >= totalBytes) {
+        statusBar()->clearMessage();
+        return;
+    }
+    statusBar()->showMessage(QString("Loading tweets... %1%").arg(bytesRead * 100 / totalBytes));
+}
+
+void MainWindow::handleTweetsBatchLoaded(const QVector<TweetData>& batch) {
+    // Provisional rows in file order; handleTweetsLoaded replaces them with the filtered, sorted list
+    m_tweetListWidget->blockSignals(true); // Nothing can be selected until the indexes exist
+    for (const TweetData& tweet : batch) {
+        QListWidgetItem* item = new QListWidgetItem(tweet.id, m_tweetListWidget);
+        item->setData(Qt::UserRole, tweet.id);
+        updateFavoriteIcon(item, tweet.id);
+    }
+    m_tweetListWidget->blockSignals(false);
+}
+
 void MainWindow::handleFavoritesChanged() {
     for (int i = 0; i < m_tweetListWidget->count(); ++i) {
         QListWidgetItem* item = m_tweetListWidget->item(i);
@@ -502,15 +568,13 @@ void MainWindow::handleFavoritesChanged() {
         }
     }
     if (m_filterPanelWidget->isFavoritesFilterActive()) {
-        applyAllFilters();
+        applyAllFilters(); // Asynchronous; populateTweetList settles the selection when it lands
     }
     QListWidgetItem* currentItem = m_tweetListWidget->currentItem();
     if (currentItem) {
         QString currentTweetId = currentItem->data(Qt::UserRole).toString();
         const TweetData* td = m_tweetRepository->findTweetById(currentTweetId);
         if (td) displayTweetDetails(td); // Refreshes metadata including favorite status
-    } else if (m_tweetListWidget->count() == 0) {
-        displayTweetDetails(nullptr);
     }
     updateActionStates();
 }
@@ -520,16 +584,29 @@ void MainWindow::handleTweetsModified()
     qInfo() << "MainWindow notified: Tweets modified in repository.";
     if (m_filterPanelWidget && m_tweetRepository) {
         m_filterPanelWidget->populateFilters(
-            m_tweetRepository->getAllUniqueAuthors(),
-            m_tweetRepository->getAllUniqueSonicTags(),
-            m_tweetRepository->getAllUniqueTechniqueTags(),
-            m_tweetRepository->getAllUniqueUgens()
+            m_tweetRepository->getFacetCounts(FacetKind::Author),
+            m_tweetRepository->getFacetCounts(FacetKind::SonicTag),
+            m_tweetRepository->getFacetCounts(FacetKind::TechniqueTag),
+            m_tweetRepository->getFacetCounts(FacetKind::Ugen)
         );
     }
     applyAllFilters(); 
     updateActionStates();
 }
 
+void MainWindow::handleSaveFinished(const QString& filePath, int tweetCount)
+{
+    qInfo() << "MainWindow notified: Saved" << tweetCount << "tweets to" << filePath;
+    statusBar()->showMessage(QString("Tweet collection saved successfully (%1 tweets).").arg(tweetCount), 3000);
+}
+
+void MainWindow::handleSaveFailed(const QString& filePath, const QString& errorMessage)
+{
+    statusBar()->clearMessage();
+    QMessageBox::critical(this, "Save Error", "Could not save tweets to:\n" + filePath + "\n" + errorMessage +
+                          "\n\nThe previous file was left untouched.");
+}
+
 // --- Slots for Menu Actions ---
 void MainWindow::onFileNewTweet()
 {
@@ -552,7 +629,7 @@ void MainWindow::onFileSaveAllChanges()
 {
     if (m_tweetRepository) {
         if (m_tweetRepository->saveTweetsToResource()) { 
-            statusBar()->showMessage("Tweet collection saved successfully.", 3000);
+            statusBar()->showMessage("Saving tweet collection..."); // handleSaveFinished/handleSaveFailed report back
         }
     }
 }
@@ -634,23 +711,78 @@ void MainWindow::onHelpAbout()
 void MainWindow::applyAllFilters()
 {
     if (!m_tweetRepository || !m_tweetFilterEngine) return;
+    if (m_tweetRepository->isLoadInProgress()) return; // The list holds provisional rows; handleTweetsLoaded filters once the load lands
     FilterCriteria criteria;
     criteria.searchText = m_searchLineEdit->text();
     criteria.favoritesOnly = m_filterPanelWidget->isFavoritesFilterActive();
-    criteria.favoriteTweetIds = &m_favoritesManager->getFavoriteTweetIds();
     criteria.useAndLogic = m_filterPanelWidget->isMatchAllLogic();
     criteria.checkedAuthors = m_filterPanelWidget->getCheckedAuthors();
     criteria.checkedSonicTags = m_filterPanelWidget->getCheckedSonicTags();
     criteria.checkedTechniqueTags = m_filterPanelWidget->getCheckedTechniqueTags();
     criteria.checkedUgens = m_filterPanelWidget->getCheckedUgens();
-
-    const QVector<TweetData>& allTweets = m_tweetRepository->getAllTweets();
-    m_currentlyDisplayedTweets = m_tweetFilterEngine->filterTweets(allTweets, criteria);
-    populateTweetList(m_currentlyDisplayedTweets);
-    qInfo() << "Filters applied, list count:" << m_tweetListWidget->count();
+    criteria.verifyUgensInSource = m_filterPanelWidget->isVerifyUgensInSource();
+    criteria.sortMode = static_cast<TweetSortMode>(m_sortComboBox->currentData().toInt());
+    criteria.repositoryVersion = m_tweetRepository->version();
+    criteria.favoritesVersion = m_favoritesManager->version();
+
+    // Filter a snapshot on m_filterPool so typing never waits for a slow query. Each request
+    // takes a new generation; a request that sees a newer one stops and delivers nothing.
+    const quint64 generation = ++m_filterGeneration;
+    QSharedPointer<const RepositorySnapshot> snapshot(new RepositorySnapshot(m_tweetRepository->snapshot()));
+    const QSet<QString> favoriteIds = m_favoritesManager->getFavoriteTweetIds(); // Shared copy, safe off-thread
+    QtConcurrent::run(m_filterPool, [this, generation, snapshot, favoriteIds, criteria]() mutable {
+        auto isCancelled = [this, generation]() { return m_filterGeneration.load() != generation; };
+        if (isCancelled()) return;
+        criteria.favoriteTweetIds = &favoriteIds;
+        FilterReport report;
+        const QVector<const TweetData*> results = m_tweetFilterEngine->filterTweets(
+            snapshot->tweets, snapshot->facets, snapshot->trigrams, snapshot->searchKeys, criteria, &report,
+            isCancelled);
+        if (report.cancelled || isCancelled()) return;
+        const FacetCounts facetCounts = TweetFilterEngine::facetCountsFor(snapshot->tweets, snapshot->facets, results);
+        if (isCancelled()) return;
+        QMetaObject::invokeMethod(this, [this, generation, snapshot, results, report, facetCounts,
+                                         searchText = criteria.searchText]() {
+            handleFilterResults(generation, snapshot, results, report, facetCounts, searchText);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::handleFilterResults(quint64 generation, const QSharedPointer<const RepositorySnapshot>& snapshot,
+                                     const QVector<const TweetData*>& results, const FilterReport& report,
+                                     const FacetCounts& facetCounts, const QString& searchText)
+{
+    if (generation != m_filterGeneration.load()) return; // A newer request is on its way
+    if (snapshot->version != m_tweetRepository->version()) {
+        applyAllFilters(); // Rows changed while filtering; the result may list stale tweets
+        return;
+    }
+    // Keep only the ids: holding the snapshot past this call would make every later edit detach
+    // (deep-copy) the repository's rows and indexes. The snapshot dies with the last request using it.
+    QStringList displayedTweetIds;
+    displayedTweetIds.reserve(results.size());
+    for (const TweetData* tweet : results) {
+        if (tweet) displayedTweetIds.append(tweet->id);
+    }
+    populateTweetList(displayedTweetIds);
+    m_filterPanelWidget->updateFacetCounts(facetCounts.authors, facetCounts.sonicTags,
+                                           facetCounts.techniqueTags, facetCounts.ugens);
+    if (!report.queryError.isEmpty()) {
+        statusBar()->showMessage("Query error: " + report.queryError + " (searched as plain text)", 4000);
+    } else if (report.usedFuzzyMatch) {
+        statusBar()->showMessage(QString("No exact matches for \"%1\"; showing closest names.").arg(searchText), 4000);
+    }
+    if (!report.explain.isEmpty()) {
+        // EXPLAIN output takes over the metadata pane until another tweet is selected
+        m_metadataTextEdit->setPlainText(report.explain.join(QLatin1Char('\n')));
+        qInfo().noquote() << report.explain.join(QLatin1Char('\n'));
+    }
+    const TweetFilterEngine::CacheStats cache = m_tweetFilterEngine->cacheStats();
+    qInfo() << "Filters applied, list count:" << m_tweetListWidget->count()
+            << "result cache hits/misses:" << cache.hits << "/" << cache.misses;
 }
 
-void MainWindow::populateTweetList(const QVector<const TweetData*>& tweetsToDisplay) {
+void MainWindow::populateTweetList(const QStringList& tweetIdsToDisplay) {
     m_tweetListWidget->blockSignals(true); 
 
     QString previouslySelectedId;
@@ -664,12 +796,11 @@ void MainWindow::populateTweetList(const QVector<const TweetData*>& tweetsToDisp
     m_tweetListWidget->clear();
     QListWidgetItem* itemToSelectAgain = nullptr;
 
-    for (const TweetData* tweet : tweetsToDisplay) {
-        if (!tweet) continue;
-        QListWidgetItem* newItem = new QListWidgetItem(tweet->id, m_tweetListWidget);
-        newItem->setData(Qt::UserRole, tweet->id);
-        updateFavoriteIcon(newItem, tweet->id);
-        if (tweet->id == previouslySelectedId) {
+    for (const QString& tweetId : tweetIdsToDisplay) {
+        QListWidgetItem* newItem = new QListWidgetItem(tweetId, m_tweetListWidget);
+        newItem->setData(Qt::UserRole, tweetId);
+        updateFavoriteIcon(newItem, tweetId);
+        if (tweetId == previouslySelectedId) {
             itemToSelectAgain = newItem;
         }
     }
@@ -810,13 +941,15 @@ void MainWindow::displayNdefCode(const TweetData* tweet)
 void MainWindow::updateActionStates()
 {
     bool itemSelected = (m_tweetListWidget && m_tweetListWidget->currentItem() != nullptr);
+    bool loading = m_tweetRepository && m_tweetRepository->isLoadInProgress(); // The repository refuses edits and saves until then
 
-    if(m_editTweetAction) m_editTweetAction->setEnabled(itemSelected);
-    if(m_deleteTweetAction) m_deleteTweetAction->setEnabled(itemSelected);
+    if(m_newTweetAction) m_newTweetAction->setEnabled(!loading);
+    if(m_editTweetAction) m_editTweetAction->setEnabled(itemSelected && !loading);
+    if(m_deleteTweetAction) m_deleteTweetAction->setEnabled(itemSelected && !loading);
     if(m_copyCodeAction) m_copyCodeAction->setEnabled(itemSelected);
     if(m_toggleFavoriteAction) m_toggleFavoriteAction->setEnabled(itemSelected);
     
     if(m_saveAllAction && m_tweetRepository) {
-        m_saveAllAction->setEnabled(!m_tweetRepository->getCurrentResourcePath().startsWith(":/"));
+        m_saveAllAction->setEnabled(!loading && !m_tweetRepository->getCurrentResourcePath().startsWith(":/"));
     }
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 
 #include <QMainWindow>
 #include <QVector>
+#include <QSharedPointer>
+#include <atomic>
 
 // Qt Widget Includes needed for member declarations
 #include <QTextEdit>
@@ -28,6 +30,7 @@ QT_BEGIN_NAMESPACE
 class QSettings;
 class QListWidgetItem;
 class QKeyEvent;
+class QThreadPool;
 QT_END_NAMESPACE
 
 class SearchLineEdit;
@@ -35,6 +38,9 @@ class TweetRepository;
 class FavoritesManager;
 class FilterPanelWidget;
 class TweetFilterEngine;
+struct FilterReport;
+struct FacetCounts;
+struct RepositorySnapshot;
 class TweetEditDialog; 
 // NdefGenerator is included above
 
@@ -63,8 +69,13 @@ private slots:
     // Slots for Manager/Repository Signals
     void handleRepositoryLoadError(const QString& title, const QString& message);
     void handleTweetsLoaded(int count);
+    void handleLoadProgress(qint64 bytesRead, qint64 totalBytes);
+    void handleTweetsBatchLoaded(const QVector<TweetData>& batch);
+    void handleLoadFinished(const QString& filePath, bool ok); // Falls back to the resource if the user file failed
     void handleFavoritesChanged();
     void handleTweetsModified(); 
+    void handleSaveFinished(const QString& filePath, int tweetCount);
+    void handleSaveFailed(const QString& filePath, const QString& errorMessage);
 
     // Slots for Menu Actions
     void onFileNewTweet();
@@ -84,13 +95,18 @@ private:
     void setupUi();
     void setupMenuBar(); 
     void setupModelsAndManagers();
+    void loadInitialTweets(); // Starts loading the user file, else the bundled resource; queued from the constructor
     void setupActions(); 
     void connectSignals();
     void updateActionStates(); 
 
     // Helper Methods
     void displayTweetDetails(const TweetData* tweet);
-    void populateTweetList(const QVector<const TweetData*>& tweetsToDisplay);
+    void populateTweetList(const QStringList& tweetIdsToDisplay);
+    // Delivery end of applyAllFilters; drops anything but the newest request's result
+    void handleFilterResults(quint64 generation, const QSharedPointer<const RepositorySnapshot>& snapshot,
+                             const QVector<const TweetData*>& results, const FilterReport& report,
+                             const FacetCounts& facetCounts, const QString& searchText);
     void updateFavoriteIcon(QListWidgetItem* item, const QString& tweetId);
     QWidget* createRightPanel(); 
     QWidget* createNdefPanel();  
@@ -119,6 +135,7 @@ private:
 
     // Main Layout Widgets
     SearchLineEdit *m_searchLineEdit;
+    QComboBox *m_sortComboBox;
     QSplitter *m_mainSplitter;
     FilterPanelWidget *m_filterPanelWidget;
     QListWidget *m_tweetListWidget;
@@ -147,12 +164,12 @@ private:
     TweetRepository *m_tweetRepository;
     FavoritesManager *m_favoritesManager;
     TweetFilterEngine *m_tweetFilterEngine;
+    QThreadPool *m_filterPool;                // One thread, so the engine only ever runs one request at a time
+    std::atomic<quint64> m_filterGeneration;  // Bumped per applyAllFilters; older requests see it and give up
     NdefGenerator *m_ndefGenerator;     
 
     // --- State for Ndef Formatting Options ---
     NdefFormattingOptions m_currentNdefOptions; 
-
-    QVector<const TweetData*> m_currentlyDisplayedTweets;
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file
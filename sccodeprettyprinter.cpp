@@ -6,20 +6,77 @@
 
 extern "C" TSLanguage* tree_sitter_supercollider();
 
+namespace {
+// Tree-sitter reports no tree sizes; its subtrees run to roughly this much per source byte for
+// SuperCollider's short tokens, which is all the LRU budget needs
+const qsizetype kTreeBytesPerSourceByte = 16;
+const qsizetype kDefaultTreeCacheBytes = 8 * 1024 * 1024; // A couple of thousand tweets
+
+QByteArrayView trimmedView(QByteArrayView text)
+{
+    auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f'; };
+    qsizetype begin = 0;
+    qsizetype end = text.size();
+    while (begin < end && isSpace(text.at(begin))) ++begin;
+    while (end > begin && isSpace(text.at(end - 1))) --end;
+    return text.sliced(begin, end - begin);
+}
+
+// Spacing rules as switches over token bytes, so joining a token costs a few branches and never
+// builds a temporary string. Openers take no space after them, closers and separators none before.
+constexpr bool isOpener(char c)
+{
+    switch (c) {
+    case '(': case '[': case '{': case '.': case '~': case '\\': case '#': case '`':
+        return true;
+    default:
+        return false;
+    }
+}
+
+constexpr bool isCloser(char c)
+{
+    switch (c) {
+    case ')': case ']': case '}': case '.': case ',': case ';':
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Text ending in beforeLast, last wants no space after it ('\0' when there is no beforeLast)
+constexpr bool noSpaceAfterTail(char beforeLast, char last)
+{
+    return isOpener(last) || (beforeLast == '-' && last == '>');
+}
+
+// A token starting with first, second wants no space before it ('\0' when there is no second)
+constexpr bool noSpaceBeforeHead(char first, char second)
+{
+    return isCloser(first) || (first == '-' && second == '>');
+}
+
+// The whole token is an opener or "->"
+constexpr bool isNoSpaceAfterToken(const char* text, qsizetype length)
+{
+    return (length == 1 && isOpener(text[0])) || (length == 2 && text[0] == '-' && text[1] == '>');
+}
+
+static_assert(noSpaceAfterTail('x', '(') && noSpaceAfterTail('-', '>') && !noSpaceAfterTail('x', ')'), "opener tails");
+static_assert(noSpaceBeforeHead(';', '\0') && noSpaceBeforeHead('-', '>') && !noSpaceBeforeHead('-', '1'), "closer heads");
+static_assert(isNoSpaceAfterToken("->", 2) && isNoSpaceAfterToken("~", 1) && !isNoSpaceAfterToken("-", 1), "opener tokens");
+}
+
 SCCodePrettyPrinter::SCCodePrettyPrinter(int indentWidth, int maxInlineArgs)
     : m_parser(nullptr), 
       m_scLanguage(nullptr), 
       m_currentTree(nullptr),
+      m_treeCache(kDefaultTreeCacheBytes),
       m_indentWidth(indentWidth),
       m_indentString(QString(indentWidth, ' ')),
+      m_indentUtf8(QByteArray(indentWidth, ' ')),
       m_maxInlineArgs(maxInlineArgs)
 {
-    m_noSpaceAfterTypes << "(" << "[" << "{" << "." << "~" << "\\" << "#" << "`" << "->" ; 
-    m_noSpaceBeforeTypes << ")" << "]" << "}" << "." << "," << ";" << "->" ;
-    
-    m_binaryOperators << "&&" << "||" << "&" << "|" << "==" << "!=" << "<" << "<=" << ">" << ">="
-                      << "<<" << ">>" << "+" << "-" << "++" << "*" << "/" << "%" << "**" << "=" << "+/+"
-                      << "->" << "?" << "!?" << "??"; 
 }
 
 SCCodePrettyPrinter::~SCCodePrettyPrinter()
@@ -53,10 +110,120 @@ bool SCCodePrettyPrinter::initialize()
         m_scLanguage = nullptr;
         return false; 
     }
+    registerNodeHandlers();
     qInfo() << "SCCodePrettyPrinter initialized successfully with SuperCollider grammar.";
     return true; 
 }
 
+void SCCodePrettyPrinter::registerNodeHandlers()
+{
+    // Node types with their own layout rules. Every other type falls through to formatNode's
+    // generic leaf/children handling, so a new rule is one more line here plus its handler.
+    struct Registration {
+        const char* type;
+        NodeHandler handler;
+    };
+    static const Registration registrations[] = {
+        {"source_file", &SCCodePrettyPrinter::formatSourceFile},
+        {"_expression_sequence", &SCCodePrettyPrinter::formatExpressionSequence},
+        {"_expression", &SCCodePrettyPrinter::formatExpression},
+        {"_expression_statement", &SCCodePrettyPrinter::formatTransparentNode},
+        {"_object", &SCCodePrettyPrinter::formatTransparentNode},
+        {"unnamed_argument", &SCCodePrettyPrinter::formatTransparentNode},
+        {"named_argument", &SCCodePrettyPrinter::formatTransparentNode},
+        {"value", &SCCodePrettyPrinter::formatTransparentNode},
+        {"receiver", &SCCodePrettyPrinter::formatTransparentNode},
+        {"left", &SCCodePrettyPrinter::formatTransparentNode},
+        {"right", &SCCodePrettyPrinter::formatTransparentNode},
+        {"identifier", &SCCodePrettyPrinter::formatTransparentNode},
+        {"class", &SCCodePrettyPrinter::formatTransparentNode},
+        {"method_name", &SCCodePrettyPrinter::formatTransparentNode},
+        {"function_block", &SCCodePrettyPrinter::formatFunctionBlock},
+        {"code_block", &SCCodePrettyPrinter::formatCodeBlock},
+        {"parameter_list", &SCCodePrettyPrinter::formatParameterList},
+        {"function_call", &SCCodePrettyPrinter::formatCall},
+        {"method_call", &SCCodePrettyPrinter::formatCall},
+        {"binary_expression", &SCCodePrettyPrinter::formatBinaryExpression},
+        {"collection", &SCCodePrettyPrinter::formatCollection},
+        {"arithmetic_series", &SCCodePrettyPrinter::formatArithmeticSeries},
+    };
+
+    // What isNodeSimple and areChildrenSimpleEnoughForInline need to know about a node type
+    struct TraitRegistration {
+        const char* type;
+        SimpleRule rule;
+        quint8 flags;
+    };
+    static const TraitRegistration traitRegistrations[] = {
+        {"number", SimpleRule::Terminal, InlineElement},
+        {"integer", SimpleRule::Terminal, 0},
+        {"float", SimpleRule::Terminal, 0},
+        {"string", SimpleRule::Terminal, 0},
+        {"symbol", SimpleRule::Terminal, 0},
+        {"char", SimpleRule::Terminal, 0},
+        {"bool", SimpleRule::Terminal, 0},
+        {"identifier", SimpleRule::Terminal, 0},
+        {"local_var", SimpleRule::Terminal, 0},
+        {"environment_var", SimpleRule::Terminal, 0},
+        {"builtin_var", SimpleRule::Terminal, 0},
+        {"instance_var", SimpleRule::Terminal, 0},
+        {"class", SimpleRule::Terminal, 0},
+        {"method_name", SimpleRule::Terminal, 0},
+        {"unnamed_argument", SimpleRule::UnnamedArgument, InlineArgument},
+        {"named_argument", SimpleRule::NamedArgument, InlineArgument},
+        {"function_call", SimpleRule::Call, 0},
+        {"method_call", SimpleRule::Call, 0},
+        {"collection", SimpleRule::Collection, 0},
+        {"arithmetic_series", SimpleRule::Collection, 0},
+        {"binary_expression", SimpleRule::BinaryExpression, 0},
+        {"_object", SimpleRule::Fallback, InlineElement},
+        {"associative_item", SimpleRule::Fallback, InlineElement},
+        {"parameter_call_list", SimpleRule::Fallback, ParameterCallList},
+        {"seq", SimpleRule::Fallback, Seq},
+        {"collection_type", SimpleRule::Fallback, NotCollectionItem},
+        {"ref", SimpleRule::Fallback, NotCollectionItem},
+        {"#", SimpleRule::Fallback, NotCollectionItem},
+        {"[", SimpleRule::Fallback, NotCollectionItem},
+        {"]", SimpleRule::Fallback, NotCollectionItem},
+        {"(", SimpleRule::Fallback, NotCollectionItem},
+        {")", SimpleRule::Fallback, NotCollectionItem},
+        {",", SimpleRule::Fallback, NotCollectionItem},
+    };
+
+    // A name can belong to several symbols (a named rule and a same-spelled keyword, or aliases),
+    // and ts_language_symbol_for_name only reports one, so every symbol is matched by name
+    const uint32_t symbolCount = ts_language_symbol_count(m_scLanguage);
+    m_nodeHandlers.fill(nullptr, symbolCount);
+    m_symbolTraits.fill(SymbolTraits(), symbolCount);
+    for (uint32_t symbol = 0; symbol < symbolCount; ++symbol) {
+        const char* name = ts_language_symbol_name(m_scLanguage, TSSymbol(symbol));
+        if (!name) continue;
+        for (const Registration& registration : registrations) {
+            if (strcmp(name, registration.type) == 0) {
+                m_nodeHandlers[symbol] = registration.handler;
+                break;
+            }
+        }
+        for (const TraitRegistration& registration : traitRegistrations) {
+            if (strcmp(name, registration.type) == 0) {
+                m_symbolTraits[symbol] = {registration.rule, registration.flags};
+                break;
+            }
+        }
+    }
+
+    auto fieldId = [this](const char* name) {
+        return ts_language_field_id_for_name(m_scLanguage, name, uint32_t(strlen(name))); // 0 if the grammar lacks it
+    };
+    m_fields.receiver = fieldId("receiver");
+    m_fields.name = fieldId("name");
+    m_fields.methodName = fieldId("method_name");
+    m_fields.collectionType = fieldId("collection_type");
+    m_fields.left = fieldId("left");
+    m_fields.operatorField = fieldId("operator");
+    m_fields.right = fieldId("right");
+}
+
 bool SCCodePrettyPrinter::parse(const QString& scCode)
 {
     if (!m_parser || !m_scLanguage) {
@@ -68,20 +235,159 @@ bool SCCodePrettyPrinter::parse(const QString& scCode)
         m_currentTree = nullptr;
     }
     m_lastParsedCode = scCode; 
-    QByteArray codeUtf8 = scCode.toUtf8(); 
-    m_currentTree = ts_parser_parse_string(
+    m_lastParsedUtf8 = scCode.toUtf8();
+    const QByteArray& codeUtf8 = m_lastParsedUtf8;
+
+    const size_t key = qHash(scCode);
+    if (const CachedTree* cached = m_treeCache.object(key)) { // Also marks it most recently used
+        if (cached->code == scCode) {
+            m_currentTree = ts_tree_copy(cached->tree); // Shallow and O(1): subtrees are reference counted
+            return true;
+        }
+    }
+
+    TSTree* tree = ts_parser_parse_string(
         m_parser,
         nullptr, 
         codeUtf8.constData(),
         codeUtf8.length()
     );
-    if (!m_currentTree) {
+    if (!tree) {
         qWarning() << "SCCodePrettyPrinter: Tree-sitter failed to parse (returned null tree).";
         return false; 
     }
+    const qsizetype cost = estimatedTreeBytes(codeUtf8.length());
+    if (cost <= m_treeCache.maxCost()) {
+        CachedTree* entry = new CachedTree;
+        entry->tree = tree;
+        entry->code = scCode;
+        m_treeCache.insert(key, entry, cost); // Evicts least recently used trees past the budget
+        m_currentTree = ts_tree_copy(tree);
+    } else {
+        m_currentTree = tree; // Too big to keep around
+    }
     return true; 
 }
 
+bool SCCodePrettyPrinter::applyEdit(const TextEdit& edit)
+{
+    if (!m_parser || !m_scLanguage) {
+        qWarning() << "SCCodePrettyPrinter not initialized. Cannot parse.";
+        return false;
+    }
+    const quint32 oldLength = quint32(m_lastParsedUtf8.size());
+    const quint32 startByte = qMin(edit.startByte, oldLength);
+    const quint32 oldEndByte = qBound(startByte, edit.oldEndByte, oldLength);
+    const quint32 newEndByte = startByte + quint32(edit.newText.size());
+
+    QByteArray codeUtf8;
+    codeUtf8.reserve(oldLength - (oldEndByte - startByte) + edit.newText.size());
+    codeUtf8.append(m_lastParsedUtf8.constData(), startByte);
+    codeUtf8.append(edit.newText);
+    codeUtf8.append(m_lastParsedUtf8.constData() + oldEndByte, oldLength - oldEndByte);
+
+    if (m_currentTree) {
+        // m_currentTree may share subtrees with a cached tree; tree-sitter copies them on write,
+        // so the cached tree keeps describing the old code
+        TSInputEdit inputEdit;
+        inputEdit.start_byte = startByte;
+        inputEdit.old_end_byte = oldEndByte;
+        inputEdit.new_end_byte = newEndByte;
+        inputEdit.start_point = pointAt(m_lastParsedUtf8, startByte);
+        inputEdit.old_end_point = pointAt(m_lastParsedUtf8, oldEndByte);
+        inputEdit.new_end_point = pointAt(codeUtf8, newEndByte);
+        ts_tree_edit(m_currentTree, &inputEdit);
+    }
+
+    TSTree* tree = ts_parser_parse_string(
+        m_parser,
+        m_currentTree, // Unchanged subtrees outside the edited range are reused as they are
+        codeUtf8.constData(),
+        codeUtf8.length()
+    );
+    if (!tree) {
+        qWarning() << "SCCodePrettyPrinter: Tree-sitter failed to reparse after an edit (returned null tree).";
+        return false;
+    }
+    if (m_currentTree) {
+        ts_tree_delete(m_currentTree);
+    }
+    m_currentTree = tree;
+    m_lastParsedUtf8 = codeUtf8;
+    m_lastParsedCode = QString::fromUtf8(codeUtf8);
+    return true;
+}
+
+TSPoint SCCodePrettyPrinter::pointAt(const QByteArray& utf8, quint32 byte)
+{
+    TSPoint point = {0, 0};
+    const char* data = utf8.constData();
+    quint32 lineStart = 0;
+    for (quint32 i = 0; i < byte; ++i) {
+        if (data[i] == '\n') {
+            ++point.row;
+            lineStart = i + 1;
+        }
+    }
+    point.column = byte - lineStart;
+    return point;
+}
+
+QVector<SCCodePrettyPrinter::SyntaxError> SCCodePrettyPrinter::syntaxErrors() const
+{
+    QVector<SyntaxError> errors;
+    if (!m_currentTree) return errors;
+    TSNode root = ts_tree_root_node(m_currentTree);
+    if (!ts_node_has_error(root)) return errors;
+
+    // Only subtrees flagged with has_error can contain one, so the walk skips the rest
+    QStack<TSNode> pending;
+    pending.push(root);
+    while (!pending.isEmpty()) {
+        const TSNode node = pending.pop();
+        const bool missing = ts_node_is_missing(node);
+        if (missing || qstrcmp(ts_node_type(node), "ERROR") == 0) {
+            SyntaxError error;
+            error.startByte = ts_node_start_byte(node);
+            error.endByte = ts_node_end_byte(node);
+            const TSPoint start = ts_node_start_point(node);
+            error.row = start.row;
+            error.column = start.column;
+            error.missing = missing;
+            if (missing) {
+                error.message = QString("Missing '%1'").arg(QString::fromUtf8(ts_node_type(node)));
+            } else {
+                QString text = QString::fromUtf8(getNodeText(node)).simplified();
+                if (text.length() > 20) text = text.left(20) + "...";
+                error.message = QString("Unexpected '%1'").arg(text);
+            }
+            errors.append(error);
+            continue; // Errors nested in an ERROR node are part of the same mistake
+        }
+        // Children pushed in reverse so they pop in source order
+        for (uint32_t i = ts_node_child_count(node); i > 0; --i) {
+            const TSNode child = ts_node_child(node, i - 1);
+            if (ts_node_has_error(child)) pending.push(child);
+        }
+    }
+    return errors;
+}
+
+void SCCodePrettyPrinter::setTreeCacheCapacity(qsizetype bytes)
+{
+    m_treeCache.setMaxCost(qMax<qsizetype>(0, bytes));
+}
+
+qsizetype SCCodePrettyPrinter::treeCacheBytes() const
+{
+    return m_treeCache.totalCost();
+}
+
+qsizetype SCCodePrettyPrinter::estimatedTreeBytes(qsizetype utf8Length)
+{
+    return qMax<qsizetype>(1, utf8Length * kTreeBytesPerSourceByte);
+}
+
 QString SCCodePrettyPrinter::getASTasSExpression() const
 {
     if (!m_currentTree) {
@@ -102,61 +408,53 @@ QString SCCodePrettyPrinter::getIndentString() const
     return m_indentString;
 }
 
-QString SCCodePrettyPrinter::getNodeText(TSNode node) const {
-    if (ts_node_is_null(node)) return QString();
-    uint32_t start_byte = ts_node_start_byte(node);
-    uint32_t end_byte = ts_node_end_byte(node);
-    if (end_byte < start_byte) return QString(); 
-    int length = end_byte - start_byte;
-    if (length < 0) return QString();
+QByteArrayView SCCodePrettyPrinter::getNodeText(TSNode node) const {
+    if (ts_node_is_null(node)) return QByteArrayView();
+    const uint32_t start_byte = ts_node_start_byte(node);
+    const uint32_t end_byte = ts_node_end_byte(node);
+    if (end_byte < start_byte) return QByteArrayView();
 
-    QByteArray codeUtf8 = m_lastParsedCode.toUtf8();
-    if (start_byte + length > (uint32_t)codeUtf8.length()) { 
-        qWarning() << "Node byte range out of bounds:" << start_byte << "-" << end_byte << "for code length" << codeUtf8.length();
-        if (start_byte >= (uint32_t)codeUtf8.length()) return QString();
-        length = codeUtf8.length() - start_byte;
-        if (length < 0) return QString();
+    const uint32_t codeLength = uint32_t(m_lastParsedUtf8.length());
+    if (end_byte > codeLength) {
+        qWarning() << "Node byte range out of bounds:" << start_byte << "-" << end_byte << "for code length" << codeLength;
+        if (start_byte >= codeLength) return QByteArrayView();
+        return QByteArrayView(m_lastParsedUtf8.constData() + start_byte, codeLength - start_byte);
     }
-    return QString::fromUtf8(codeUtf8.constData() + start_byte, length);
+    return QByteArrayView(m_lastParsedUtf8.constData() + start_byte, end_byte - start_byte);
 }
 
-void SCCodePrettyPrinter::appendWithIntelligentSpace(QString& builder, const QString& text, bool forceNoSpaceBefore) const {
+void SCCodePrettyPrinter::appendWithIntelligentSpace(QByteArray& builder, QByteArrayView text, bool forceNoSpaceBefore) const {
     if (text.isEmpty()) return;
 
-    bool noSpaceBeforeThis = forceNoSpaceBefore || 
-                             (text.length() > 0 && m_noSpaceBeforeTypes.contains(text.at(0))) ||
-                             (text.length() > 1 && m_noSpaceBeforeTypes.contains(text.left(2)));
-    
-    bool noSpaceAfterPrevious = false;
-    if (!builder.isEmpty()) {
-        noSpaceAfterPrevious = m_noSpaceAfterTypes.contains(builder.right(1)) ||
-                               (builder.length() > 1 && m_noSpaceAfterTypes.contains(builder.right(2)));
-    }
-
-    if (!builder.isEmpty() && 
-        !builder.endsWith(' ') && 
-        !builder.endsWith('\n') &&
-        !noSpaceAfterPrevious &&
-        !noSpaceBeforeThis) 
-    {
-        builder.append(' ');
+    // The builder is edited in place (chop, truncate) all over formatNode, so its last two bytes
+    // are the reliable record of the previous token; reading them is as cheap as tracking it
+    const qsizetype length = builder.size();
+    if (length > 0 && !forceNoSpaceBefore) {
+        const char last = builder.at(length - 1);
+        const char beforeLast = length > 1 ? builder.at(length - 2) : '\0';
+        if (last != ' ' && last != '\n' &&
+            !noSpaceAfterTail(beforeLast, last) &&
+            !noSpaceBeforeHead(text.at(0), text.size() > 1 ? text.at(1) : '\0'))
+        {
+            builder.append(' ');
+        }
     }
     builder.append(text);
 }
 
-void SCCodePrettyPrinter::appendNewlineAndIndent(QString& builder, int indentLevel) const {
+void SCCodePrettyPrinter::appendNewlineAndIndent(QByteArray& builder, int indentLevel) const {
     int i = builder.length() - 1;
-    while (i >= 0 && (builder.at(i) == QChar(' ') || builder.at(i) == QChar('\t'))) {
+    while (i >= 0 && (builder.at(i) == ' ' || builder.at(i) == '\t')) {
         i--;
     }
-    if (i < 0 || builder.at(i) != QChar('\n')) { 
+    if (i < 0 || builder.at(i) != '\n') { 
         builder.append('\n');
     } else { 
         builder.truncate(i + 1);
     }
     
     for (int j = 0; j < indentLevel; ++j) {
-        builder.append(m_indentString);
+        builder.append(m_indentUtf8);
     }
 }
 
@@ -166,7 +464,8 @@ QString SCCodePrettyPrinter::formatCurrentTree() const
         qWarning() << "SCCodePrettyPrinter: No tree to format. Parse code first.";
         return m_lastParsedCode; 
     }
-    QString formattedCode;
+    QByteArray formattedCode; // UTF-8 throughout; node text is appended straight from m_lastParsedUtf8
+    formattedCode.reserve(m_lastParsedUtf8.size() + m_lastParsedUtf8.size() / 2);
     TSNode rootNode = ts_tree_root_node(m_currentTree);
     
     if (ts_node_is_error(rootNode) && ts_node_child_count(rootNode) == 0) { 
@@ -175,20 +474,18 @@ QString SCCodePrettyPrinter::formatCurrentTree() const
     }
 
     formatNode(rootNode, formattedCode, 0, true); 
-    return formattedCode.trimmed(); 
+    return QString::fromUtf8(formattedCode.trimmed()); 
 }
 
-void SCCodePrettyPrinter::formatNode(TSNode node, QString& builder, int currentIndentLevel, bool parentPermitsInline) const
+void SCCodePrettyPrinter::formatNode(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const
 {
     if (ts_node_is_null(node)) return;
 
-    const char* type = ts_node_type(node);
     bool isNamed = ts_node_is_named(node);
     uint32_t childCount = ts_node_child_count(node);
-    uint32_t namedChildCount = ts_node_named_child_count(node);
 
-    if (strcmp(type, "ERROR") == 0 || (ts_node_is_missing(node) && !isNamed) ) { 
-        QString nodeStr = getNodeText(node).trimmed();
+    if (ts_node_is_error(node) || (ts_node_is_missing(node) && !isNamed) ) { 
+        const QByteArrayView nodeStr = trimmedView(getNodeText(node));
         if(!nodeStr.isEmpty()) appendWithIntelligentSpace(builder, nodeStr);
         return;
     }
@@ -196,366 +493,420 @@ void SCCodePrettyPrinter::formatNode(TSNode node, QString& builder, int currentI
         return;
     }
 
-    if (strcmp(type, "source_file") == 0) {
-        TSTreeCursor cursor = ts_tree_cursor_new(node);
-        if (ts_tree_cursor_goto_first_child(&cursor)) {
-            bool firstInFile = true;
+    const TSSymbol symbol = ts_node_symbol(node); // The alias, if any, so it agrees with ts_node_type
+    if (symbol < m_nodeHandlers.size()) {
+        if (const NodeHandler handler = m_nodeHandlers.at(symbol)) {
+            (this->*handler)(node, builder, currentIndentLevel, parentPermitsInline);
+            return;
+        }
+    }
+
+    if (isNamed && childCount == 0) { 
+        appendWithIntelligentSpace(builder, trimmedView(getNodeText(node)), parentPermitsInline && builder.endsWith("."));
+    } 
+    else if (!isNamed && childCount == 0) { 
+        const QByteArrayView txt = trimmedView(getNodeText(node));
+        bool forceNoSpace = isNoSpaceAfterToken(txt.data(), txt.size()) || builder.isEmpty(); 
+        if (txt.size() == 1 && txt.at(0) == ';' && builder.endsWith(' ')) builder.chop(1); 
+        appendWithIntelligentSpace(builder, txt, forceNoSpace);
+    }
+    else if (isNamed) { 
+        TSTreeCursor cursor = ts_tree_cursor_new(node); 
+        if (ts_tree_cursor_goto_first_child(&cursor)) { 
             do {
-                TSNode currentNode = ts_tree_cursor_current_node(&cursor);
-                if (!firstInFile) {
-                    // Ensure previous statement ended with a newline before starting new one
-                    if (!builder.isEmpty() && !builder.endsWith('\n')) {
-                        builder.append('\n'); // Add newline if missing
-                    }
-                     // Apply indent for the new line if builder isn't just a newline
-                    if (builder.endsWith('\n') && builder.length() > 1) { // length > 1 to avoid indenting an empty builder
-                        for(int i=0; i < currentIndentLevel; ++i) builder.append(m_indentString);
-                    }
+                formatNode(ts_tree_cursor_current_node(&cursor), builder, currentIndentLevel, true); 
+            } while (ts_tree_cursor_goto_next_sibling(&cursor)); 
+        }
+        ts_tree_cursor_delete(&cursor); 
+    }
+}
+
+void SCCodePrettyPrinter::formatSourceFile(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const
+{
+    TSTreeCursor cursor = ts_tree_cursor_new(node);
+    if (ts_tree_cursor_goto_first_child(&cursor)) {
+        bool firstInFile = true;
+        do {
+            TSNode currentNode = ts_tree_cursor_current_node(&cursor);
+            if (!firstInFile) {
+                // Ensure previous statement ended with a newline before starting new one
+                if (!builder.isEmpty() && !builder.endsWith('\n')) {
+                    builder.append('\n'); // Add newline if missing
                 }
-                formatNode(currentNode, builder, currentIndentLevel, false);
-                firstInFile = false;
-            } while (ts_tree_cursor_goto_next_sibling(&cursor));
+                 // Apply indent for the new line if builder isn't just a newline
+                if (builder.endsWith('\n') && builder.length() > 1) { // length > 1 to avoid indenting an empty builder
+                    for(int i=0; i < currentIndentLevel; ++i) builder.append(m_indentUtf8);
+                }
+            }
+            formatNode(currentNode, builder, currentIndentLevel, false);
+            firstInFile = false;
+        } while (ts_tree_cursor_goto_next_sibling(&cursor));
+    }
+    ts_tree_cursor_delete(&cursor);
+}
+
+void SCCodePrettyPrinter::formatExpressionSequence(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const
+{
+    TSTreeCursor cursor = ts_tree_cursor_new(node);
+    if (ts_tree_cursor_goto_first_child(&cursor)) {
+        do {
+            formatNode(ts_tree_cursor_current_node(&cursor), builder, currentIndentLevel, false); 
+        } while (ts_tree_cursor_goto_next_sibling(&cursor));
+    }
+    ts_tree_cursor_delete(&cursor);
+}
+
+void SCCodePrettyPrinter::formatExpression(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const
+{
+    const uint32_t childCount = ts_node_child_count(node);
+    TSNode statementNode = ts_node_child(node, 0);
+    TSNode semicolonNode = {}; 
+    if (childCount > 1) semicolonNode = ts_node_child(node, 1); 
+
+    if (!ts_node_is_null(statementNode)) {
+        formatNode(statementNode, builder, currentIndentLevel, parentPermitsInline); 
+    }
+    if (!ts_node_is_null(semicolonNode) && strcmp(ts_node_type(semicolonNode), ";") == 0) {
+        if (builder.endsWith(' ')) builder.chop(1);
+        builder.append(getNodeText(semicolonNode));
+    }
+    
+    if (!parentPermitsInline ) {
+        if (!builder.isEmpty() && !builder.endsWith('\n')) {
+             builder.append('\n');
         }
-        ts_tree_cursor_delete(&cursor);
-    } else if (strcmp(type, "_expression_sequence") == 0) { 
+        // Don't add indent here, next statement in source_file/expression_sequence will handle its own leading indent.
+        // Only add indent if we are sure a new *indented line* should start,
+        // but _expression itself doesn't start a new scope.
+    }
+}
+
+void SCCodePrettyPrinter::formatTransparentNode(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const
+{
+    const bool isNamed = ts_node_is_named(node);
+    const uint32_t childCount = ts_node_child_count(node);
+    if (isNamed && childCount == 0) { 
+        appendWithIntelligentSpace(builder, trimmedView(getNodeText(node)), parentPermitsInline && builder.endsWith("."));
+    } else { 
         TSTreeCursor cursor = ts_tree_cursor_new(node);
         if (ts_tree_cursor_goto_first_child(&cursor)) {
             do {
-                formatNode(ts_tree_cursor_current_node(&cursor), builder, currentIndentLevel, false); 
+                 formatNode(ts_tree_cursor_current_node(&cursor), builder, currentIndentLevel, parentPermitsInline);
             } while (ts_tree_cursor_goto_next_sibling(&cursor));
         }
         ts_tree_cursor_delete(&cursor);
-    } else if (strcmp(type, "_expression") == 0) { 
-        TSNode statementNode = ts_node_child(node, 0);
-        TSNode semicolonNode = {}; 
-        if (childCount > 1) semicolonNode = ts_node_child(node, 1); 
+    }
+}
 
-        if (!ts_node_is_null(statementNode)) {
-            formatNode(statementNode, builder, currentIndentLevel, parentPermitsInline); 
-        }
-        if (!ts_node_is_null(semicolonNode) && strcmp(ts_node_type(semicolonNode), ";") == 0) {
-            if (builder.endsWith(' ')) builder.chop(1);
-            builder.append(getNodeText(semicolonNode));
-        }
-        
-        if (!parentPermitsInline ) {
-            if (!builder.isEmpty() && !builder.endsWith('\n')) {
-                 builder.append('\n');
-            }
-            // Don't add indent here, next statement in source_file/expression_sequence will handle its own leading indent.
-            // Only add indent if we are sure a new *indented line* should start,
-            // but _expression itself doesn't start a new scope.
-        }
+void SCCodePrettyPrinter::formatFunctionBlock(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const
+{
+    formatBlock(node, builder, currentIndentLevel, parentPermitsInline, false);
+}
 
-    } else if (strcmp(type, "_expression_statement") == 0 || strcmp(type, "_object") == 0 || 
-               strcmp(type, "unnamed_argument") == 0 || strcmp(type, "named_argument") == 0 ||
-               strcmp(type, "value") == 0 || strcmp(type, "receiver") == 0 || 
-               strcmp(type, "left") == 0 || strcmp(type, "right") == 0 ||
-               strcmp(type, "identifier") == 0 || strcmp(type, "class") == 0 || strcmp(type, "method_name") == 0 ) {
-        if (isNamed && childCount == 0) { 
-            appendWithIntelligentSpace(builder, getNodeText(node).trimmed(), parentPermitsInline && builder.endsWith("."));
-        } else { 
-            TSTreeCursor cursor = ts_tree_cursor_new(node);
-            if (ts_tree_cursor_goto_first_child(&cursor)) {
-                do {
-                     formatNode(ts_tree_cursor_current_node(&cursor), builder, currentIndentLevel, parentPermitsInline);
-                } while (ts_tree_cursor_goto_next_sibling(&cursor));
-            }
-            ts_tree_cursor_delete(&cursor);
-        }
-    } else if (strcmp(type, "function_block") == 0 || strcmp(type, "code_block") == 0) {
-        bool isCodeBlock = strcmp(type, "code_block") == 0;
-        appendWithIntelligentSpace(builder, isCodeBlock ? "(" : "{", true);
-        
-        bool hasSignificantContent = false;
-        TSTreeCursor contentCheckCursor = ts_tree_cursor_new(node);
-        if (ts_tree_cursor_goto_first_child(&contentCheckCursor)) {
-            do {
-                TSNode child = ts_tree_cursor_current_node(&contentCheckCursor);
-                const char* ct = ts_node_type(child);
-                 if (strcmp(ct, "{") != 0 && strcmp(ct, "}") != 0 && 
-                    strcmp(ct, "(") != 0 && strcmp(ct, ")") != 0 &&
-                    strcmp(ct, "parameter_list") !=0 ) { 
-                    if (strcmp(ct, "_expression_sequence") == 0 && ts_node_child_count(child) == 0) {
-                    } else {
-                        hasSignificantContent = true;
-                        break;
-                    }
+void SCCodePrettyPrinter::formatCodeBlock(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const
+{
+    formatBlock(node, builder, currentIndentLevel, parentPermitsInline, true);
+}
+
+void SCCodePrettyPrinter::formatBlock(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline, bool isCodeBlock) const
+{
+    const uint32_t childCount = ts_node_child_count(node);
+    appendWithIntelligentSpace(builder, isCodeBlock ? "(" : "{", true);
+    
+    bool hasSignificantContent = false;
+    TSTreeCursor contentCheckCursor = ts_tree_cursor_new(node);
+    if (ts_tree_cursor_goto_first_child(&contentCheckCursor)) {
+        do {
+            TSNode child = ts_tree_cursor_current_node(&contentCheckCursor);
+            const char* ct = ts_node_type(child);
+             if (strcmp(ct, "{") != 0 && strcmp(ct, "}") != 0 && 
+                strcmp(ct, "(") != 0 && strcmp(ct, ")") != 0 &&
+                strcmp(ct, "parameter_list") !=0 ) { 
+                if (strcmp(ct, "_expression_sequence") == 0 && ts_node_child_count(child) == 0) {
+                } else {
+                    hasSignificantContent = true;
+                    break;
                 }
-            } while (ts_tree_cursor_goto_next_sibling(&contentCheckCursor));
-        }
-        ts_tree_cursor_delete(&contentCheckCursor);
-        
-        if (hasSignificantContent) {
-            appendNewlineAndIndent(builder, currentIndentLevel + 1);
-        } else if (!isCodeBlock && childCount <= 2 && parentPermitsInline ) { 
-             builder.append(' '); 
-        }
+            }
+        } while (ts_tree_cursor_goto_next_sibling(&contentCheckCursor));
+    }
+    ts_tree_cursor_delete(&contentCheckCursor);
+    
+    if (hasSignificantContent) {
+        appendNewlineAndIndent(builder, currentIndentLevel + 1);
+    } else if (!isCodeBlock && childCount <= 2 && parentPermitsInline ) { 
+         builder.append(' '); 
+    }
 
-        TSTreeCursor childCursor = ts_tree_cursor_new(node);
-        if (ts_tree_cursor_goto_first_child(&childCursor)) {
-            do {
-                TSNode child = ts_tree_cursor_current_node(&childCursor);
-                const char* childType = ts_node_type(child);
-                if (strcmp(childType, "{") == 0 || strcmp(childType, "}") == 0 ||
-                    strcmp(childType, "(") == 0 || strcmp(childType, ")") == 0 ) continue; 
-                formatNode(child, builder, currentIndentLevel + 1, !hasSignificantContent); 
-            } while (ts_tree_cursor_goto_next_sibling(&childCursor));
-        }
-        ts_tree_cursor_delete(&childCursor);
+    TSTreeCursor childCursor = ts_tree_cursor_new(node);
+    if (ts_tree_cursor_goto_first_child(&childCursor)) {
+        do {
+            TSNode child = ts_tree_cursor_current_node(&childCursor);
+            const char* childType = ts_node_type(child);
+            if (strcmp(childType, "{") == 0 || strcmp(childType, "}") == 0 ||
+                strcmp(childType, "(") == 0 || strcmp(childType, ")") == 0 ) continue; 
+            formatNode(child, builder, currentIndentLevel + 1, !hasSignificantContent); 
+        } while (ts_tree_cursor_goto_next_sibling(&childCursor));
+    }
+    ts_tree_cursor_delete(&childCursor);
 
-        if (hasSignificantContent) {
-            if (builder.endsWith(m_indentString.repeated(currentIndentLevel + 1))) {
-                 builder.chop(m_indentString.length() * (currentIndentLevel + 1));
-                 if (builder.endsWith('\n')) builder.chop(1);
-            }
-            appendNewlineAndIndent(builder, currentIndentLevel); 
-        } else if (!isCodeBlock && builder.endsWith(' ') && childCount <=2) { 
-             builder.chop(1); 
+    if (hasSignificantContent) {
+        if (builder.endsWith(m_indentUtf8.repeated(currentIndentLevel + 1))) {
+             builder.chop(m_indentUtf8.length() * (currentIndentLevel + 1));
+             if (builder.endsWith('\n')) builder.chop(1);
         }
-        
-        if (builder.endsWith(' ') && hasSignificantContent && !isCodeBlock) builder.chop(1);
-        else if (builder.endsWith(' ') && isCodeBlock) builder.chop(1);
+        appendNewlineAndIndent(builder, currentIndentLevel); 
+    } else if (!isCodeBlock && builder.endsWith(' ') && childCount <=2) { 
+         builder.chop(1); 
+    }
+    
+    if (builder.endsWith(' ') && hasSignificantContent && !isCodeBlock) builder.chop(1);
+    else if (builder.endsWith(' ') && isCodeBlock) builder.chop(1);
 
-        builder.append(isCodeBlock ? ")" : "}");
+    builder.append(isCodeBlock ? ")" : "}");
+}
 
-    } else if (strcmp(type, "parameter_list") == 0) {
-        TSNode firstToken = ts_node_child(node, 0); 
-        appendWithIntelligentSpace(builder, getNodeText(firstToken).trimmed());
-        if (strcmp(ts_node_type(firstToken), "arg")==0) appendWithIntelligentSpace(builder, " ");
+void SCCodePrettyPrinter::formatParameterList(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const
+{
+    const uint32_t childCount = ts_node_child_count(node);
+    TSNode firstToken = ts_node_child(node, 0); 
+    appendWithIntelligentSpace(builder, trimmedView(getNodeText(firstToken)));
+    if (strcmp(ts_node_type(firstToken), "arg")==0) appendWithIntelligentSpace(builder, " ");
 
-        TSTreeCursor cursor = ts_tree_cursor_new(node); 
-        if (ts_tree_cursor_goto_first_child(&cursor)) { 
-            bool firstParamContent = true;
-            while(ts_tree_cursor_goto_next_sibling(&cursor)) { 
-                TSNode child = ts_tree_cursor_current_node(&cursor); 
-                const char* childType = ts_node_type(child);
-                if (strcmp(childType, ";") == 0 || strcmp(childType, "|") == 0) break; 
-                
-                if(strcmp(childType, ",") == 0) {
-                     if(builder.endsWith(' ')) builder.chop(1); builder.append(getNodeText(child)); appendWithIntelligentSpace(builder, " ");
-                } else {
-                     formatNode(child, builder, currentIndentLevel, true); 
-                }
-                firstParamContent = false;
+    TSTreeCursor cursor = ts_tree_cursor_new(node); 
+    if (ts_tree_cursor_goto_first_child(&cursor)) { 
+        bool firstParamContent = true;
+        while(ts_tree_cursor_goto_next_sibling(&cursor)) { 
+            TSNode child = ts_tree_cursor_current_node(&cursor); 
+            const char* childType = ts_node_type(child);
+            if (strcmp(childType, ";") == 0 || strcmp(childType, "|") == 0) break; 
+            
+            if(strcmp(childType, ",") == 0) {
+                 if(builder.endsWith(' ')) builder.chop(1); builder.append(getNodeText(child)); appendWithIntelligentSpace(builder, " ");
+            } else {
+                 formatNode(child, builder, currentIndentLevel, true); 
             }
+            firstParamContent = false;
         }
-        ts_tree_cursor_delete(&cursor); 
+    }
+    ts_tree_cursor_delete(&cursor); 
 
-        if (builder.endsWith(' ')) builder.chop(1); 
-        appendWithIntelligentSpace(builder, getNodeText(ts_node_child(node, childCount-1)).trimmed()); 
+    if (builder.endsWith(' ')) builder.chop(1); 
+    appendWithIntelligentSpace(builder, trimmedView(getNodeText(ts_node_child(node, childCount-1))));
+}
 
-    } else if (strcmp(type, "function_call") == 0 || strcmp(type, "method_call") == 0) {
-        TSNode receiverNode = {}; TSNode nameNode = {}; TSNode paramListNode = {};
-        TSNode openParenToken = {}; TSNode closeParenToken = {}; TSNode trailingFunctionBlock = {};
+void SCCodePrettyPrinter::formatCall(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const
+{
+    TSNode receiverNode = {}; TSNode nameNode = {}; TSNode paramListNode = {};
+    TSNode openParenToken = {}; TSNode closeParenToken = {}; TSNode trailingFunctionBlock = {};
 
-        TSTreeCursor c = ts_tree_cursor_new(node);
-        if(ts_tree_cursor_goto_first_child(&c)) {  
-            do {
-                TSNode child = ts_tree_cursor_current_node(&c);
-                const char* ct = ts_node_type(child);
-                const char* fn = ts_tree_cursor_current_field_name(&c); 
-
-                if (fn && strcmp(fn, "receiver") == 0) receiverNode = child;
-                else if (fn && (strcmp(fn, "name") == 0 || strcmp(fn, "method_name") == 0)) nameNode = child;
-                else if (strcmp(ct, "parameter_call_list") == 0) paramListNode = child;
-                else if (strcmp(ct, "(") == 0 && ts_node_is_null(openParenToken)) openParenToken = child;
-                else if (strcmp(ct, ")") == 0) closeParenToken = child; 
-                else if (strcmp(ct, "function_block") == 0 && ts_node_is_null(paramListNode) && ts_node_is_null(openParenToken)) {
-                    trailingFunctionBlock = child;
-                } else if (ts_node_is_null(nameNode) && ts_node_is_null(receiverNode) && 
-                         (strcmp(ct, "identifier") == 0 || strcmp(ct, "class") == 0)) {
-                    nameNode = child;
-                }
-            } while (ts_tree_cursor_goto_next_sibling(&c));
-        }
-        ts_tree_cursor_delete(&c);
+    TSTreeCursor c = ts_tree_cursor_new(node);
+    if(ts_tree_cursor_goto_first_child(&c)) {  
+        do {
+            TSNode child = ts_tree_cursor_current_node(&c);
+            const char* ct = ts_node_type(child);
+            const TSFieldId fieldId = ts_tree_cursor_current_field_id(&c); 
 
-        if (!ts_node_is_null(receiverNode)) {
-            formatNode(receiverNode, builder, currentIndentLevel, true); 
-            builder.append("."); 
-        }
-        if (!ts_node_is_null(nameNode)) {
-            appendWithIntelligentSpace(builder, getNodeText(nameNode), !ts_node_is_null(receiverNode));
-        }
+            if (fieldId != 0 && fieldId == m_fields.receiver) receiverNode = child;
+            else if (fieldId != 0 && (fieldId == m_fields.name || fieldId == m_fields.methodName)) nameNode = child;
+            else if (strcmp(ct, "parameter_call_list") == 0) paramListNode = child;
+            else if (strcmp(ct, "(") == 0 && ts_node_is_null(openParenToken)) openParenToken = child;
+            else if (strcmp(ct, ")") == 0) closeParenToken = child; 
+            else if (strcmp(ct, "function_block") == 0 && ts_node_is_null(paramListNode) && ts_node_is_null(openParenToken)) {
+                trailingFunctionBlock = child;
+            } else if (ts_node_is_null(nameNode) && ts_node_is_null(receiverNode) && 
+                     (strcmp(ct, "identifier") == 0 || strcmp(ct, "class") == 0)) {
+                nameNode = child;
+            }
+        } while (ts_tree_cursor_goto_next_sibling(&c));
+    }
+    ts_tree_cursor_delete(&c);
 
-        if (!ts_node_is_null(openParenToken)) { 
-            appendWithIntelligentSpace(builder, "(", true);
-        }
+    if (!ts_node_is_null(receiverNode)) {
+        formatNode(receiverNode, builder, currentIndentLevel, true); 
+        builder.append("."); 
+    }
+    if (!ts_node_is_null(nameNode)) {
+        appendWithIntelligentSpace(builder, getNodeText(nameNode), !ts_node_is_null(receiverNode));
+    }
 
-        bool breakArgs = false;
-        uint32_t argCount = 0; 
-        if (!ts_node_is_null(paramListNode)) {
-            argCount = ts_node_named_child_count(paramListNode); 
-             if (argCount > 0) {
-                 if (!parentPermitsInline || argCount > m_maxInlineArgs || 
-                     !areChildrenSimpleEnoughForInline(paramListNode, {"unnamed_argument", "named_argument"}, m_maxInlineArgs)) {
-                     breakArgs = true;
-                 }
+    if (!ts_node_is_null(openParenToken)) { 
+        appendWithIntelligentSpace(builder, "(", true);
+    }
+
+    bool breakArgs = false;
+    uint32_t argCount = 0; 
+    if (!ts_node_is_null(paramListNode)) {
+        argCount = ts_node_named_child_count(paramListNode); 
+         if (argCount > 0) {
+             if (!parentPermitsInline || argCount > m_maxInlineArgs || 
+                 !areChildrenSimpleEnoughForInline(paramListNode, InlineArgument, m_maxInlineArgs)) {
+                 breakArgs = true;
              }
-        }
-        
-        if (breakArgs && argCount > 0 && !ts_node_is_null(openParenToken)) { 
-             appendNewlineAndIndent(builder, currentIndentLevel + 1);
-        }
+         }
+    }
+    
+    if (breakArgs && argCount > 0 && !ts_node_is_null(openParenToken)) { 
+         appendNewlineAndIndent(builder, currentIndentLevel + 1);
+    }
 
-        if (!ts_node_is_null(paramListNode)) {
-            TSTreeCursor argCursor = ts_tree_cursor_new(paramListNode); 
-            if (ts_tree_cursor_goto_first_child(&argCursor)) { 
-                bool firstArgInLine = true;
-                do {
-                    TSNode argChildNode = ts_tree_cursor_current_node(&argCursor); 
-                    const char* argChildType = ts_node_type(argChildNode);
-                    if (strcmp(argChildType, ",") == 0) {
-                        if(builder.endsWith(' ')) builder.chop(1);
-                        builder.append(getNodeText(argChildNode)); 
-                        if (breakArgs) appendNewlineAndIndent(builder, currentIndentLevel + 1);
-                        else appendWithIntelligentSpace(builder, " "); 
-                        firstArgInLine = true; 
-                    } else { 
-                        if (!firstArgInLine && !breakArgs && !builder.endsWith(" ") && !(builder.endsWith(m_indentString) && builder.endsWith("\n"+m_indentString))) {
-                             appendWithIntelligentSpace(builder, " "); 
-                        }
-                        formatNode(argChildNode, builder, currentIndentLevel + (breakArgs ? 1:0), !breakArgs);
-                        firstArgInLine = false;
+    if (!ts_node_is_null(paramListNode)) {
+        TSTreeCursor argCursor = ts_tree_cursor_new(paramListNode); 
+        if (ts_tree_cursor_goto_first_child(&argCursor)) { 
+            bool firstArgInLine = true;
+            do {
+                TSNode argChildNode = ts_tree_cursor_current_node(&argCursor); 
+                const char* argChildType = ts_node_type(argChildNode);
+                if (strcmp(argChildType, ",") == 0) {
+                    if(builder.endsWith(' ')) builder.chop(1);
+                    builder.append(getNodeText(argChildNode)); 
+                    if (breakArgs) appendNewlineAndIndent(builder, currentIndentLevel + 1);
+                    else appendWithIntelligentSpace(builder, " "); 
+                    firstArgInLine = true; 
+                } else { 
+                    if (!firstArgInLine && !breakArgs && !builder.endsWith(" ") && !(builder.endsWith(m_indentUtf8) && builder.endsWith("\n"+m_indentUtf8))) {
+                         appendWithIntelligentSpace(builder, " "); 
                     }
-                } while (ts_tree_cursor_goto_next_sibling(&argCursor)); 
-            }
-            ts_tree_cursor_delete(&argCursor); 
-        }
-            
-        if (breakArgs && argCount > 0 && !ts_node_is_null(openParenToken)) { 
-            if (!builder.endsWith(m_indentString.repeated(currentIndentLevel))) { // If last arg didn't add newline+indent for this level
-                 appendNewlineAndIndent(builder, currentIndentLevel);
-            }
-        }
-        
-        if (!ts_node_is_null(closeParenToken)) { 
-             if (builder.endsWith(m_indentString) && builder.endsWith("\n" + m_indentString) && breakArgs && argCount > 0) {
-                 builder.chop(m_indentString.length()); 
-                 if(builder.endsWith('\n')) builder.chop(1); 
-             } else if (builder.endsWith(' ')) {
-                 builder.chop(1);
-             }
-            builder.append(")");
+                    formatNode(argChildNode, builder, currentIndentLevel + (breakArgs ? 1:0), !breakArgs);
+                    firstArgInLine = false;
+                }
+            } while (ts_tree_cursor_goto_next_sibling(&argCursor)); 
         }
+        ts_tree_cursor_delete(&argCursor); 
+    }
         
-        if(!ts_node_is_null(trailingFunctionBlock)){ 
-            appendWithIntelligentSpace(builder, " "); 
-            formatNode(trailingFunctionBlock, builder, currentIndentLevel, false); 
+    if (breakArgs && argCount > 0 && !ts_node_is_null(openParenToken)) { 
+        if (!builder.endsWith(m_indentUtf8.repeated(currentIndentLevel))) { // If last arg didn't add newline+indent for this level
+             appendNewlineAndIndent(builder, currentIndentLevel);
         }
+    }
+    
+    if (!ts_node_is_null(closeParenToken)) { 
+         if (builder.endsWith(m_indentUtf8) && builder.endsWith("\n" + m_indentUtf8) && breakArgs && argCount > 0) {
+             builder.chop(m_indentUtf8.length()); 
+             if(builder.endsWith('\n')) builder.chop(1); 
+         } else if (builder.endsWith(' ')) {
+             builder.chop(1);
+         }
+        builder.append(")");
+    }
+    
+    if(!ts_node_is_null(trailingFunctionBlock)){ 
+        appendWithIntelligentSpace(builder, " "); 
+        formatNode(trailingFunctionBlock, builder, currentIndentLevel, false); 
+    }
+}
 
-    } else if (strcmp(type, "binary_expression") == 0) {
-        TSNode left = ts_node_child_by_field_name(node, "left", strlen("left"));
-        TSNode opNode   = ts_node_child_by_field_name(node, "operator", strlen("operator"));
-        TSNode right= ts_node_child_by_field_name(node, "right", strlen("right"));
+void SCCodePrettyPrinter::formatBinaryExpression(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const
+{
+    TSNode left = ts_node_child_by_field_id(node, m_fields.left);
+    TSNode opNode   = ts_node_child_by_field_id(node, m_fields.operatorField);
+    TSNode right= ts_node_child_by_field_id(node, m_fields.right);
 
-        formatNode(left, builder, currentIndentLevel, true); 
-        if (!ts_node_is_null(opNode)) appendWithIntelligentSpace(builder, getNodeText(opNode).trimmed()); 
-        formatNode(right, builder, currentIndentLevel, true); 
+    formatNode(left, builder, currentIndentLevel, true); 
+    if (!ts_node_is_null(opNode)) appendWithIntelligentSpace(builder, trimmedView(getNodeText(opNode))); 
+    formatNode(right, builder, currentIndentLevel, true);
+}
 
-    } else if (strcmp(type, "collection") == 0 || strcmp(type, "arithmetic_series") == 0) {
-        bool isArithmetic = strcmp(type, "arithmetic_series") == 0;
-        QString openBracket = isArithmetic ? "(" : "[";
-        QString closeBracket = isArithmetic ? ")" : "]";
-        TSNode classTypeNode = {}; TSNode refNode = {}; TSNode contentSequenceNode = {}; 
+void SCCodePrettyPrinter::formatCollection(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const
+{
+    formatCollectionLike(node, builder, currentIndentLevel, parentPermitsInline, false);
+}
 
-        TSTreeCursor cursor = ts_tree_cursor_new(node); 
-        if(ts_tree_cursor_goto_first_child(&cursor)) { 
-            do {
-                TSNode child = ts_tree_cursor_current_node(&cursor); 
-                const char* childType = ts_node_type(child);
-                const char* fieldName = ts_tree_cursor_current_field_name(&cursor); 
-                
-                if (fieldName && strcmp(fieldName, "collection_type") == 0) classTypeNode = child; 
-                else if (strcmp(childType, "ref") == 0 || strcmp(childType, "#")==0) refNode = child;
-                else if (strcmp(childType, "_collection_sequence") == 0 || strcmp(childType, "_paired_associative_sequence") == 0) contentSequenceNode = child;
-                else if (isArithmetic && (strcmp(childType, "number")==0 || strcmp(childType, ",")==0 || strcmp(childType, "..")==0) ) {
-                    if(ts_node_is_null(contentSequenceNode)) contentSequenceNode = node; 
-                }
-            } while(ts_tree_cursor_goto_next_sibling(&cursor)); 
-        }
-        ts_tree_cursor_delete(&cursor); 
+void SCCodePrettyPrinter::formatArithmeticSeries(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const
+{
+    formatCollectionLike(node, builder, currentIndentLevel, parentPermitsInline, true);
+}
 
-        if (!ts_node_is_null(refNode)) appendWithIntelligentSpace(builder, getNodeText(refNode), true);
-        if (!ts_node_is_null(classTypeNode)) formatNode(classTypeNode, builder, currentIndentLevel, true); 
-        appendWithIntelligentSpace(builder, openBracket, !ts_node_is_null(classTypeNode) || !ts_node_is_null(refNode) );
-
-        bool breakElements = false;
-        uint32_t actualElementCount = 0;
-        if (!ts_node_is_null(contentSequenceNode)) {
-            TSTreeCursor tempCursor = ts_tree_cursor_new(contentSequenceNode);
-            if (ts_tree_cursor_goto_first_child(&tempCursor)) {
-                do {
-                    if (strcmp(ts_node_type(ts_tree_cursor_current_node(&tempCursor)), ",") !=0) actualElementCount++;
-                } while (ts_tree_cursor_goto_next_sibling(&tempCursor));
-            }
-            ts_tree_cursor_delete(&tempCursor);
+void SCCodePrettyPrinter::formatCollectionLike(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline, bool isArithmetic) const
+{
+    const char* openBracket = isArithmetic ? "(" : "[";
+    const char* closeBracket = isArithmetic ? ")" : "]";
+    TSNode classTypeNode = {}; TSNode refNode = {}; TSNode contentSequenceNode = {}; 
 
-            if (actualElementCount > 0 && (!parentPermitsInline || !areChildrenSimpleEnoughForInline(contentSequenceNode, {"_object", "associative_item", "number"}, m_maxInlineArgs))) {
-                breakElements = true;
-            }
-        }
-        
-        if (breakElements && actualElementCount > 0) appendNewlineAndIndent(builder, currentIndentLevel + 1);
-
-        if (!ts_node_is_null(contentSequenceNode)) {
-            TSTreeCursor elCursor = ts_tree_cursor_new(contentSequenceNode); 
-            if (ts_tree_cursor_goto_first_child(&elCursor)) { 
-                bool firstElementInLine = true;
-                do {
-                    TSNode element = ts_tree_cursor_current_node(&elCursor); 
-                    const char* elType = ts_node_type(element);
-                    if (strcmp(elType, ",") == 0) {
-                        if (builder.endsWith(' ')) builder.chop(1);
-                        builder.append(getNodeText(element));
-                        if (breakElements) appendNewlineAndIndent(builder, currentIndentLevel + 1);
-                        else appendWithIntelligentSpace(builder, " ");
-                        firstElementInLine = true; 
-                    } else if (isArithmetic && (strcmp(elType, openBracket.toUtf8().constData()) == 0 || 
-                                                strcmp(elType, closeBracket.toUtf8().constData()) == 0 )) {
-                        continue;
-                    }
-                     else {
-                        if (!firstElementInLine && !breakElements) appendWithIntelligentSpace(builder, " ");
-                        formatNode(element, builder, currentIndentLevel + (breakElements ? 1:0), !breakElements);
-                        firstElementInLine = false;
-                    }
-                } while (ts_tree_cursor_goto_next_sibling(&elCursor)); 
+    TSTreeCursor cursor = ts_tree_cursor_new(node); 
+    if(ts_tree_cursor_goto_first_child(&cursor)) { 
+        do {
+            TSNode child = ts_tree_cursor_current_node(&cursor); 
+            const char* childType = ts_node_type(child);
+            const TSFieldId fieldId = ts_tree_cursor_current_field_id(&cursor); 
+            
+            if (fieldId != 0 && fieldId == m_fields.collectionType) classTypeNode = child; 
+            else if (strcmp(childType, "ref") == 0 || strcmp(childType, "#")==0) refNode = child;
+            else if (strcmp(childType, "_collection_sequence") == 0 || strcmp(childType, "_paired_associative_sequence") == 0) contentSequenceNode = child;
+            else if (isArithmetic && (strcmp(childType, "number")==0 || strcmp(childType, ",")==0 || strcmp(childType, "..")==0) ) {
+                if(ts_node_is_null(contentSequenceNode)) contentSequenceNode = node; 
             }
-            ts_tree_cursor_delete(&elCursor); 
-        }
-        if (breakElements && actualElementCount > 0 && !builder.endsWith('\n') ) {
-             appendNewlineAndIndent(builder, currentIndentLevel);
+        } while(ts_tree_cursor_goto_next_sibling(&cursor)); 
+    }
+    ts_tree_cursor_delete(&cursor); 
+
+    if (!ts_node_is_null(refNode)) appendWithIntelligentSpace(builder, getNodeText(refNode), true);
+    if (!ts_node_is_null(classTypeNode)) formatNode(classTypeNode, builder, currentIndentLevel, true); 
+    appendWithIntelligentSpace(builder, openBracket, !ts_node_is_null(classTypeNode) || !ts_node_is_null(refNode) );
+
+    bool breakElements = false;
+    uint32_t actualElementCount = 0;
+    if (!ts_node_is_null(contentSequenceNode)) {
+        TSTreeCursor tempCursor = ts_tree_cursor_new(contentSequenceNode);
+        if (ts_tree_cursor_goto_first_child(&tempCursor)) {
+            do {
+                if (strcmp(ts_node_type(ts_tree_cursor_current_node(&tempCursor)), ",") !=0) actualElementCount++;
+            } while (ts_tree_cursor_goto_next_sibling(&tempCursor));
         }
-        
-        if (builder.endsWith(' ') || (builder.endsWith(m_indentString) && breakElements && actualElementCount > 0)) {
-            if (builder.endsWith(m_indentString)) builder.chop(m_indentString.length());
-            else if (builder.endsWith(' ')) builder.chop(1);
+        ts_tree_cursor_delete(&tempCursor);
+
+        if (actualElementCount > 0 && (!parentPermitsInline || !areChildrenSimpleEnoughForInline(contentSequenceNode, InlineElement, m_maxInlineArgs))) {
+            breakElements = true;
         }
-        builder.append(closeBracket);
     }
-    else if (isNamed && childCount == 0) { 
-        appendWithIntelligentSpace(builder, getNodeText(node).trimmed(), parentPermitsInline && builder.endsWith("."));
-    } 
-    else if (!isNamed && childCount == 0) { 
-        QString txt = getNodeText(node).trimmed();
-        bool forceNoSpace = m_noSpaceAfterTypes.contains(txt) || builder.isEmpty(); 
-        if (txt == ";" && builder.endsWith(' ')) builder.chop(1); 
-        appendWithIntelligentSpace(builder, txt, forceNoSpace);
-    }
-    else if (isNamed) { 
-        TSTreeCursor cursor = ts_tree_cursor_new(node); 
-        if (ts_tree_cursor_goto_first_child(&cursor)) { 
+    
+    if (breakElements && actualElementCount > 0) appendNewlineAndIndent(builder, currentIndentLevel + 1);
+
+    if (!ts_node_is_null(contentSequenceNode)) {
+        TSTreeCursor elCursor = ts_tree_cursor_new(contentSequenceNode); 
+        if (ts_tree_cursor_goto_first_child(&elCursor)) { 
+            bool firstElementInLine = true;
             do {
-                formatNode(ts_tree_cursor_current_node(&cursor), builder, currentIndentLevel, true); 
-            } while (ts_tree_cursor_goto_next_sibling(&cursor)); 
+                TSNode element = ts_tree_cursor_current_node(&elCursor); 
+                const char* elType = ts_node_type(element);
+                if (strcmp(elType, ",") == 0) {
+                    if (builder.endsWith(' ')) builder.chop(1);
+                    builder.append(getNodeText(element));
+                    if (breakElements) appendNewlineAndIndent(builder, currentIndentLevel + 1);
+                    else appendWithIntelligentSpace(builder, " ");
+                    firstElementInLine = true; 
+                } else if (isArithmetic && (strcmp(elType, openBracket) == 0 || 
+                                            strcmp(elType, closeBracket) == 0 )) {
+                    continue;
+                }
+                 else {
+                    if (!firstElementInLine && !breakElements) appendWithIntelligentSpace(builder, " ");
+                    formatNode(element, builder, currentIndentLevel + (breakElements ? 1:0), !breakElements);
+                    firstElementInLine = false;
+                }
+            } while (ts_tree_cursor_goto_next_sibling(&elCursor)); 
         }
-        ts_tree_cursor_delete(&cursor); 
+        ts_tree_cursor_delete(&elCursor); 
+    }
+    if (breakElements && actualElementCount > 0 && !builder.endsWith('\n') ) {
+         appendNewlineAndIndent(builder, currentIndentLevel);
+    }
+    
+    if (builder.endsWith(' ') || (builder.endsWith(m_indentUtf8) && breakElements && actualElementCount > 0)) {
+        if (builder.endsWith(m_indentUtf8)) builder.chop(m_indentUtf8.length());
+        else if (builder.endsWith(' ')) builder.chop(1);
     }
+    builder.append(closeBracket);
+}
+
+SCCodePrettyPrinter::SymbolTraits SCCodePrettyPrinter::traitsOf(TSNode node) const
+{
+    const TSSymbol symbol = ts_node_symbol(node);
+    return symbol < m_symbolTraits.size() ? m_symbolTraits.at(symbol) : SymbolTraits();
 }
 
-bool SCCodePrettyPrinter::areChildrenSimpleEnoughForInline(TSNode parentNode, const QSet<QString>& interestingChildTypes, int maxChildrenForInline) const {
+bool SCCodePrettyPrinter::areChildrenSimpleEnoughForInline(TSNode parentNode, quint8 interestingChildFlag, int maxChildrenForInline) const {
     if (ts_node_is_null(parentNode)) return true;
     QList<TSNode> relevantNodes;
 
@@ -563,7 +914,7 @@ bool SCCodePrettyPrinter::areChildrenSimpleEnoughForInline(TSNode parentNode, co
     if (ts_tree_cursor_goto_first_child(&cursor)) { 
         do {
             TSNode child = ts_tree_cursor_current_node(&cursor); 
-            if (interestingChildTypes.contains(QLatin1String(ts_node_type(child)))) {
+            if (traitsOf(child).flags & interestingChildFlag) {
                 relevantNodes.append(child);
             }
         } while (ts_tree_cursor_goto_next_sibling(&cursor)); 
@@ -586,18 +937,12 @@ bool SCCodePrettyPrinter::isNodeSimple(TSNode node, int depth) const {
         return false; 
     }
 
-    const char* type = ts_node_type(node);
+    const SimpleRule rule = traitsOf(node).rule;
     uint32_t namedChildCount = ts_node_named_child_count(node);
     uint32_t childCount = ts_node_child_count(node); // Total children, including anonymous
 
     // Terminals we consider simple
-    if (strcmp(type, "number") == 0 || strcmp(type, "integer") == 0 || strcmp(type, "float") == 0 ||
-        strcmp(type, "string") == 0 || strcmp(type, "symbol") == 0 || strcmp(type, "char") == 0 ||
-        strcmp(type, "bool") == 0 || strcmp(type, "identifier") == 0 ||
-        strcmp(type, "local_var") == 0 || strcmp(type, "environment_var") == 0 ||
-        strcmp(type, "builtin_var") == 0 || strcmp(type, "instance_var") == 0 ||
-        strcmp(type, "class") == 0 || strcmp(type, "method_name") == 0 ) 
-    {
+    if (rule == SimpleRule::Terminal) {
         // These are simple if they don't have further complex named children
         for(uint32_t i=0; i < namedChildCount; ++i) { 
             if(!isNodeSimple(ts_node_named_child(node,i), depth+1)) return false;
@@ -605,21 +950,21 @@ bool SCCodePrettyPrinter::isNodeSimple(TSNode node, int depth) const {
         return true;
     }
 
-    if (strcmp(type, "unnamed_argument") == 0) {
+    if (rule == SimpleRule::UnnamedArgument) {
         if (namedChildCount > 0) {
             return isNodeSimple(ts_node_named_child(node, 0), depth + 1);
         }
         return true; 
     }
     
-    if (strcmp(type, "named_argument") == 0) {
-        TSNode nameFieldNode = ts_node_child_by_field_name(node, "name", strlen("name"));
+    if (rule == SimpleRule::NamedArgument) {
+        TSNode nameFieldNode = ts_node_child_by_field_id(node, m_fields.name);
         TSNode valueNode = {}; 
         if (!ts_node_is_null(nameFieldNode)) {
             uint32_t nameFieldChildCount = ts_node_child_count(nameFieldNode);
             if (nameFieldChildCount > 0) {
                 TSNode lastChildOfNameField = ts_node_child(nameFieldNode, nameFieldChildCount - 1);
-                if (strcmp(ts_node_type(lastChildOfNameField), "seq") == 0 && ts_node_child_count(lastChildOfNameField) > 0) { 
+                if ((traitsOf(lastChildOfNameField).flags & Seq) && ts_node_child_count(lastChildOfNameField) > 0) { 
                      valueNode = ts_node_child(lastChildOfNameField, ts_node_child_count(lastChildOfNameField) -1 );
                 } else if (ts_node_is_named(lastChildOfNameField)) { 
                     valueNode = lastChildOfNameField; 
@@ -629,11 +974,11 @@ bool SCCodePrettyPrinter::isNodeSimple(TSNode node, int depth) const {
         return isNodeSimple(valueNode, depth + 1);
     }
     
-    if (strcmp(type, "function_call") == 0 || strcmp(type, "method_call") == 0) {
+    if (rule == SimpleRule::Call) {
         TSNode paramListNode = {};
         for(uint32_t i=0; i < childCount; ++i) { // Check all children for paramListNode
             TSNode child = ts_node_child(node,i);
-            if(strcmp(ts_node_type(child), "parameter_call_list") == 0) {
+            if(traitsOf(child).flags & ParameterCallList) {
                 paramListNode = child;
                 break;
             }
@@ -654,21 +999,14 @@ bool SCCodePrettyPrinter::isNodeSimple(TSNode node, int depth) const {
         return true; 
     }
     
-    if (strcmp(type, "collection") == 0 || strcmp(type, "arithmetic_series") == 0) {
+    if (rule == SimpleRule::Collection) {
          uint32_t items = 0;
          bool complexItemFound = false;
          TSTreeCursor cursor = ts_tree_cursor_new(node); 
          if(ts_tree_cursor_goto_first_child(&cursor)){ 
             do {
                 TSNode item = ts_tree_cursor_current_node(&cursor); 
-                const char* itemType = ts_node_type(item);
-                if(ts_node_is_named(item) && 
-                   strcmp(itemType, "collection_type") != 0 && 
-                   strcmp(itemType, "ref") !=0 &&
-                   strcmp(itemType, "#") !=0 &&
-                   strcmp(itemType, "[") !=0 && strcmp(itemType, "]") !=0 && 
-                   strcmp(itemType, "(") !=0 && strcmp(itemType, ")") !=0 && 
-                   strcmp(itemType, ",") !=0 ) { 
+                if(ts_node_is_named(item) && !(traitsOf(item).flags & NotCollectionItem)) { 
                     items++;
                     if (!isNodeSimple(item, depth + 1)) {
                         complexItemFound = true;
@@ -682,9 +1020,9 @@ bool SCCodePrettyPrinter::isNodeSimple(TSNode node, int depth) const {
          return items <= (uint32_t)m_maxInlineArgs; 
     }
     
-    if (strcmp(type, "binary_expression") == 0) {
-        TSNode left = ts_node_child_by_field_name(node, "left", strlen("left"));
-        TSNode right = ts_node_child_by_field_name(node, "right", strlen("right"));
+    if (rule == SimpleRule::BinaryExpression) {
+        TSNode left = ts_node_child_by_field_id(node, m_fields.left);
+        TSNode right = ts_node_child_by_field_id(node, m_fields.right);
         return isNodeSimple(left, depth + 1) && isNodeSimple(right, depth + 1);
     }
 
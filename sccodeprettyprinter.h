@@ -2,7 +2,10 @@
 #define SCCODEPRETTYPRINTER_H
 
 #include <QString>
-#include <QSet> 
+#include <QCache>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QVector>
 
 #include <tree_sitter/api.h> // <<< ADD THIS INCLUDE HERE
 
@@ -21,7 +24,34 @@ public:
     ~SCCodePrettyPrinter();
 
     bool initialize();
+    // Recently parsed code is served from a tree cache, so flicking between tweets skips parsing
     bool parse(const QString& scCode);
+    void setTreeCacheCapacity(qsizetype bytes); // Estimated tree memory; 0 disables the cache
+    qsizetype treeCacheBytes() const;
+
+    // One replacement in the current code: UTF-8 bytes [startByte, oldEndByte) become newText
+    struct TextEdit {
+        quint32 startByte = 0;
+        quint32 oldEndByte = 0;
+        QByteArray newText; // UTF-8
+    };
+    // Applies edit to the current code, marks the changed range in the current tree (ts_tree_edit)
+    // and reparses against it, so only the subtrees around the edit are rebuilt. Parses the edited
+    // code from scratch when there is no current tree. Edited trees bypass the tree cache.
+    bool applyEdit(const TextEdit& edit);
+    const QString& currentCode() const { return m_lastParsedCode; }
+    const QByteArray& currentCodeUtf8() const { return m_lastParsedUtf8; }
+
+    // ERROR and MISSING nodes of the current tree, in source order
+    struct SyntaxError {
+        quint32 startByte = 0;  // UTF-8 offsets into currentCodeUtf8()
+        quint32 endByte = 0;    // Equals startByte for a missing token
+        quint32 row = 0;        // Zero-based
+        quint32 column = 0;     // Zero-based, in bytes
+        bool missing = false;   // An expected token is absent, rather than unexpected text present
+        QString message;
+    };
+    QVector<SyntaxError> syntaxErrors() const;
     QString getASTasSExpression() const;
 
     QString formatCurrentTree() const; 
@@ -29,27 +59,79 @@ public:
     QString getIndentString() const;
 
 private:
-    void formatNode(TSNode node, QString& builder, int currentIndentLevel, bool parentPermitsInline = false) const;
+    void formatNode(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline = false) const;
+
+    // formatNode dispatches through m_nodeHandlers, indexed by the node's TSSymbol
+    using NodeHandler = void (SCCodePrettyPrinter::*)(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const;
+    void registerNodeHandlers(); // Resolves handler and trait types to symbols and field names to ids; needs m_scLanguage
+    void formatSourceFile(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const;
+    void formatExpressionSequence(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const;
+    void formatExpression(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const;
+    void formatTransparentNode(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const;
+    void formatFunctionBlock(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const;
+    void formatCodeBlock(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const;
+    void formatBlock(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline, bool isCodeBlock) const;
+    void formatParameterList(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const;
+    void formatCall(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const;
+    void formatBinaryExpression(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const;
+    void formatCollection(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const;
+    void formatArithmeticSeries(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline) const;
+    void formatCollectionLike(TSNode node, QByteArray& builder, int currentIndentLevel, bool parentPermitsInline, bool isArithmetic) const;
     
-    QString getNodeText(TSNode node) const;
-    bool areChildrenSimpleEnoughForInline(TSNode parentNode, const QSet<QString>& interestingChildTypes, int maxChildrenForInline) const;
+    QByteArrayView getNodeText(TSNode node) const; // View into m_lastParsedUtf8; no copy, no decoding
+    // Per-symbol facts for the inline checks, resolved by registerNodeHandlers
+    enum class SimpleRule : quint8 { Fallback, Terminal, UnnamedArgument, NamedArgument, Call, Collection, BinaryExpression };
+    enum SymbolFlag : quint8 {
+        InlineArgument = 0x01,    // Counted by formatCall's inline check
+        InlineElement = 0x02,     // Counted by formatCollectionLike's inline check
+        ParameterCallList = 0x04,
+        Seq = 0x08,
+        NotCollectionItem = 0x10, // Collection type, ref, brackets and commas
+    };
+    struct SymbolTraits {
+        SimpleRule rule = SimpleRule::Fallback;
+        quint8 flags = 0;
+    };
+    SymbolTraits traitsOf(TSNode node) const;
+    bool areChildrenSimpleEnoughForInline(TSNode parentNode, quint8 interestingChildFlag, int maxChildrenForInline) const;
     bool isNodeSimple(TSNode node, int depth = 0) const; 
 
-    void appendWithIntelligentSpace(QString& builder, const QString& text, bool forceNoSpaceBefore = false) const;
-    void appendNewlineAndIndent(QString& builder, int indentLevel) const;
+    void appendWithIntelligentSpace(QByteArray& builder, QByteArrayView text, bool forceNoSpaceBefore = false) const;
+    void appendNewlineAndIndent(QByteArray& builder, int indentLevel) const;
+
+    // Owns one tree; QCache deletes evicted entries, which frees it
+    struct CachedTree {
+        TSTree* tree = nullptr;
+        QString code; // Confirms a hash hit really is the same code
+        ~CachedTree() { if (tree) ts_tree_delete(tree); }
+    };
+    static qsizetype estimatedTreeBytes(qsizetype utf8Length);
+    static TSPoint pointAt(const QByteArray& utf8, quint32 byte);
 
     TSParser *m_parser;
     TSLanguage *m_scLanguage;
-    TSTree *m_currentTree;   
+    TSTree *m_currentTree;    // Own shallow copy (ts_tree_copy) of a cached tree, or sole owner if uncached
     QString m_lastParsedCode; 
+    QByteArray m_lastParsedUtf8; // What m_currentTree's byte offsets refer to
+    QCache<size_t, CachedTree> m_treeCache; // Keyed by qHash of the code, cost in estimated bytes
+
+    QVector<NodeHandler> m_nodeHandlers; // Indexed by TSSymbol; null: generic handling
+    QVector<SymbolTraits> m_symbolTraits; // Indexed by TSSymbol
+    struct FieldIds {                    // 0 where the grammar has no such field
+        TSFieldId receiver = 0;
+        TSFieldId name = 0;
+        TSFieldId methodName = 0;
+        TSFieldId collectionType = 0;
+        TSFieldId left = 0;
+        TSFieldId operatorField = 0;
+        TSFieldId right = 0;
+    };
+    FieldIds m_fields;
 
     int m_indentWidth;          
     QString m_indentString;     
+    QByteArray m_indentUtf8;    // m_indentString for the UTF-8 builder
     int m_maxInlineArgs;        
-
-    QSet<QString> m_noSpaceAfterTypes;
-    QSet<QString> m_noSpaceBeforeTypes;
-    QSet<QString> m_binaryOperators;
 };
 
 #endif // SCCODEPRETTYPRINTER_H
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "searchkeystore.h"
+
+namespace {
+const qsizetype kMinGarbageBeforeCompaction = 64 * 1024;
+}
+
+void SearchKeyStore::clear()
+{
+    m_bytes.clear();
+    m_spans.clear();
+    m_garbageBytes = 0;
+}
+
+void SearchKeyStore::reserve(int rowCount, qsizetype byteCount)
+{
+    m_spans.reserve(rowCount);
+    m_bytes.reserve(byteCount);
+}
+
+void SearchKeyStore::setRow(int row, QStringView foldedKey)
+{
+    if (row >= m_spans.size()) m_spans.resize(row + 1);
+    Span& span = m_spans[row];
+    m_garbageBytes += span.length;
+    const QByteArray utf8 = foldedKey.toUtf8();
+    span.offset = m_bytes.size();
+    span.length = utf8.size();
+    m_bytes.append(utf8);
+    if (m_garbageBytes > kMinGarbageBeforeCompaction && m_garbageBytes * 2 > m_bytes.size()) compact();
+}
+
+void SearchKeyStore::removeRow(int row)
+{
+    if (row < 0 || row >= m_spans.size()) return;
+    m_garbageBytes += m_spans.at(row).length;
+    m_spans[row] = Span();
+}
+
+QByteArrayView SearchKeyStore::key(int row) const
+{
+    if (row < 0 || row >= m_spans.size()) return QByteArrayView();
+    const Span& span = m_spans.at(row);
+    return QByteArrayView(m_bytes.constData() + span.offset, span.length);
+}
+
+void SearchKeyStore::compact()
+{
+    // Rewrites the live keys in row order, which also restores scan locality after edits
+    QByteArray bytes;
+    bytes.reserve(m_bytes.size() - m_garbageBytes);
+    for (Span& span : m_spans) {
+        const qsizetype offset = bytes.size();
+        bytes.append(m_bytes.constData() + span.offset, span.length);
+        span.offset = offset;
+    }
+    m_bytes = bytes;
+    m_garbageBytes = 0;
+}
@@ -0,0 +1,40 @@
+#ifndef SEARCHKEYSTORE_H
+#define SEARCHKEYSTORE_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QStringView>
+#include <QVector>
+
+// Every row's TweetData::searchKey, UTF-8 encoded back to back in one buffer. The
+// search box's substring checks then walk adjacent memory with plain byte
+// searches instead of chasing one heap string per tweet, and UTF-8 halves the
+// bytes touched for the mostly-ASCII code. Keys are already case-folded, so a
+// folded term encoded once as UTF-8 matches by bytes exactly where it matched by
+// characters. A changed row's key is appended anew; the old bytes are reclaimed
+// once they make up half the buffer. Rows match TweetRepository rows.
+class SearchKeyStore
+{
+public:
+    void clear();
+    void reserve(int rowCount, qsizetype byteCount);
+    void setRow(int row, QStringView foldedKey); // Grows to cover row if needed
+    void removeRow(int row);
+
+    QByteArrayView key(int row) const; // Empty for tombstones and unknown rows
+    bool contains(int row, QByteArrayView foldedUtf8Term) const { return key(row).contains(foldedUtf8Term); }
+    qsizetype byteCount() const { return m_bytes.size(); }
+
+private:
+    struct Span {
+        qsizetype offset = 0;
+        qsizetype length = 0;
+    };
+    void compact();
+
+    QByteArray m_bytes;
+    QVector<Span> m_spans;        // Indexed by row
+    qsizetype m_garbageBytes = 0; // Bytes of replaced or removed keys still in m_bytes
+};
+
+#endif // SEARCHKEYSTORE_H
@@ -0,0 +1,56 @@
+#include "symboltable.h"
+#include <QReadLocker>
+#include <QWriteLocker>
+
+SymbolTable& SymbolTable::instance()
+{
+    static SymbolTable table;
+    return table;
+}
+
+SymbolId SymbolTable::intern(const QString& value)
+{
+    const QString key = value.toCaseFolded();
+    {
+        QReadLocker readLocker(&m_lock);
+        auto it = m_idsByFoldedKey.constFind(key);
+        if (it != m_idsByFoldedKey.constEnd()) return it.value();
+    }
+    QWriteLocker writeLocker(&m_lock);
+    auto it = m_idsByFoldedKey.constFind(key); // Another thread may have won the race
+    if (it != m_idsByFoldedKey.constEnd()) return it.value();
+    const SymbolId id = SymbolId(m_texts.size());
+    m_texts.append(value);
+    m_idsByFoldedKey.insert(key, id);
+    return id;
+}
+
+SymbolId SymbolTable::internShared(QString& value)
+{
+    const SymbolId id = intern(value);
+    QReadLocker readLocker(&m_lock);
+    const QString& stored = m_texts.at(id);
+    if (stored == value) {
+        value = stored;
+    }
+    return id;
+}
+
+SymbolId SymbolTable::lookup(const QString& value) const
+{
+    QReadLocker readLocker(&m_lock);
+    return m_idsByFoldedKey.value(value.toCaseFolded(), InvalidSymbolId);
+}
+
+QString SymbolTable::text(SymbolId id) const
+{
+    QReadLocker readLocker(&m_lock);
+    if (id >= SymbolId(m_texts.size())) return QString();
+    return m_texts.at(id);
+}
+
+int SymbolTable::size() const
+{
+    QReadLocker readLocker(&m_lock);
+    return m_texts.size();
+}
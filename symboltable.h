@@ -0,0 +1,38 @@
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
+
+#include <QString>
+#include <QHash>
+#include <QVector>
+#include <QReadWriteLock>
+
+using SymbolId = quint32;
+constexpr SymbolId InvalidSymbolId = 0xFFFFFFFFu;
+
+// Process-wide dictionary interning author, tag and UGen strings into dense ids.
+// Keys are case-folded, matching how the filters have always compared tags, and
+// each id remembers the first spelling seen for display. Ids are only valid for
+// the lifetime of the process; nothing persists them.
+class SymbolTable
+{
+public:
+    static SymbolTable& instance();
+
+    SymbolId intern(const QString& value);
+    // Interns 'value' and, when it matches the stored spelling exactly, makes it share
+    // the stored payload so repeated values across tweets cost a single allocation.
+    SymbolId internShared(QString& value);
+    SymbolId lookup(const QString& value) const; // InvalidSymbolId if never interned
+    QString text(SymbolId id) const;
+    int size() const;
+
+private:
+    SymbolTable() = default;
+    Q_DISABLE_COPY(SymbolTable)
+
+    mutable QReadWriteLock m_lock; // Interning happens on the GUI and load threads, lookups anywhere
+    QHash<QString, SymbolId> m_idsByFoldedKey;
+    QVector<QString> m_texts;
+};
+
+#endif // SYMBOLTABLE_H
@@ -0,0 +1,95 @@
+#include "trigramindex.h"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+const int kGramLength = 3;
+}
+
+void TrigramIndex::clear()
+{
+    m_postings.clear();
+}
+
+QVector<quint64> TrigramIndex::trigramsOf(const QString& foldedText)
+{
+    QVector<quint64> grams;
+    const int count = foldedText.size() - kGramLength + 1;
+    if (count <= 0) return grams;
+    grams.reserve(count);
+    const QChar* text = foldedText.constData();
+    for (int i = 0; i < count; ++i) {
+        grams.append((quint64(text[i].unicode()) << 32) | (quint64(text[i + 1].unicode()) << 16) |
+                     quint64(text[i + 2].unicode()));
+    }
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+void TrigramIndex::addRow(int row, const QString& foldedText)
+{
+    for (quint64 gram : trigramsOf(foldedText)) {
+        QVector<int>& rows = m_postings[gram];
+        if (rows.isEmpty() || rows.last() < row) {
+            rows.append(row); // Loads and appends arrive in row order
+        } else {
+            auto it = std::lower_bound(rows.begin(), rows.end(), row);
+            if (it == rows.end() || *it != row) rows.insert(it, row);
+        }
+    }
+}
+
+void TrigramIndex::removeRow(int row, const QString& foldedText)
+{
+    for (quint64 gram : trigramsOf(foldedText)) {
+        auto posting = m_postings.find(gram);
+        if (posting == m_postings.end()) continue;
+        QVector<int>& rows = posting.value();
+        auto it = std::lower_bound(rows.begin(), rows.end(), row);
+        if (it != rows.end() && *it == row) rows.erase(it);
+        if (rows.isEmpty()) m_postings.erase(posting);
+    }
+}
+
+bool TrigramIndex::candidates(const QString& foldedTerm, QVector<int>& rows) const
+{
+    rows.clear();
+    const QVector<quint64> grams = trigramsOf(foldedTerm);
+    if (grams.isEmpty()) return false;
+
+    QVector<const QVector<int>*> lists;
+    lists.reserve(grams.size());
+    for (quint64 gram : grams) {
+        auto posting = m_postings.constFind(gram);
+        if (posting == m_postings.constEnd()) return true; // A trigram nobody has: no candidates
+        lists.append(&posting.value());
+    }
+    // Shortest list first keeps every intermediate result as small as possible
+    std::sort(lists.begin(), lists.end(),
+              [](const QVector<int>* a, const QVector<int>* b) { return a->size() < b->size(); });
+
+    rows = *lists.first();
+    QVector<int> intersected;
+    for (int i = 1; i < lists.size() && !rows.isEmpty(); ++i) {
+        intersected.clear();
+        std::set_intersection(rows.cbegin(), rows.cend(), lists.at(i)->cbegin(), lists.at(i)->cend(),
+                              std::back_inserter(intersected));
+        rows.swap(intersected);
+    }
+    return true;
+}
+
+int TrigramIndex::estimateCandidates(const QString& foldedTerm) const
+{
+    const QVector<quint64> grams = trigramsOf(foldedTerm);
+    if (grams.isEmpty()) return -1;
+    int best = -1;
+    for (quint64 gram : grams) {
+        auto posting = m_postings.constFind(gram);
+        const int size = posting == m_postings.constEnd() ? 0 : int(posting.value().size());
+        if (best < 0 || size < best) best = size;
+        if (best == 0) break;
+    }
+    return best;
+}
@@ -0,0 +1,32 @@
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+// Inverted index from every three-character window of a row's case-folded search
+// text (TweetData::searchKey: id, code, description, author, tags) to the sorted
+// rows containing it. A search term's candidates are the intersection of its
+// trigrams' postings; callers still confirm with a substring check, since sharing
+// all trigrams does not imply containing the term. Rows match TweetRepository rows.
+class TrigramIndex
+{
+public:
+    void clear();
+    void addRow(int row, const QString& foldedText);
+    void removeRow(int row, const QString& foldedText); // foldedText must be what the row was added with
+
+    // Fills 'rows' (ascending) with every row holding all trigrams of foldedTerm. Returns false
+    // when the term is shorter than a trigram and so cannot narrow anything.
+    bool candidates(const QString& foldedTerm, QVector<int>& rows) const;
+    // Upper bound on candidates(): the shortest posting among the term's trigrams, -1 if too short
+    int estimateCandidates(const QString& foldedTerm) const;
+
+    static QVector<quint64> trigramsOf(const QString& foldedText); // Sorted, unique
+
+private:
+    QHash<quint64, QVector<int>> m_postings;
+};
+
+#endif // TRIGRAMINDEX_H
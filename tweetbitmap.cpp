@@ -0,0 +1,104 @@
+#include "tweetbitmap.h"
+#include <algorithm>
+
+namespace {
+int wordCountFor(int rowCount) { return (rowCount + 63) / 64; }
+}
+
+TweetBitmap::TweetBitmap(int rowCount, bool filled)
+    : m_words(wordCountFor(rowCount), filled ? ~quint64(0) : quint64(0)),
+      m_rowCount(rowCount)
+{
+    trimTail();
+}
+
+void TweetBitmap::resize(int rowCount)
+{
+    m_rowCount = rowCount;
+    if (m_words.size() > wordCountFor(rowCount)) m_words.resize(wordCountFor(rowCount));
+    trimTail();
+}
+
+void TweetBitmap::set(int row)
+{
+    const int word = row / 64;
+    if (word >= m_words.size()) m_words.resize(word + 1); // QVector zero-fills the new words
+    m_words[word] |= quint64(1) << (row % 64);
+    if (row >= m_rowCount) m_rowCount = row + 1;
+}
+
+void TweetBitmap::reset(int row)
+{
+    const int word = row / 64;
+    if (word < m_words.size()) m_words[word] &= ~(quint64(1) << (row % 64));
+}
+
+bool TweetBitmap::test(int row) const
+{
+    const int word = row / 64;
+    return word < m_words.size() && (m_words.at(word) >> (row % 64)) & 1u;
+}
+
+int TweetBitmap::count() const
+{
+    int total = 0;
+    for (quint64 word : m_words) total += qPopulationCount(word);
+    return total;
+}
+
+int TweetBitmap::intersectionCount(const TweetBitmap& other) const
+{
+    const int words = qMin(m_words.size(), other.m_words.size());
+    int total = 0;
+    for (int w = 0; w < words; ++w) total += qPopulationCount(m_words.at(w) & other.m_words.at(w));
+    return total;
+}
+
+bool TweetBitmap::isEmpty() const
+{
+    return std::all_of(m_words.cbegin(), m_words.cend(), [](quint64 word) { return word == 0; });
+}
+
+TweetBitmap& TweetBitmap::operator&=(const TweetBitmap& other)
+{
+    const int common = qMin(m_words.size(), other.m_words.size());
+    quint64* dst = m_words.data();
+    const quint64* src = other.m_words.constData();
+    for (int i = 0; i < common; ++i) dst[i] &= src[i];
+    std::fill(dst + common, dst + m_words.size(), quint64(0)); // Missing words read as zero
+    return *this;
+}
+
+TweetBitmap& TweetBitmap::operator|=(const TweetBitmap& other)
+{
+    if (m_words.size() < other.m_words.size()) m_words.resize(other.m_words.size());
+    quint64* dst = m_words.data();
+    const quint64* src = other.m_words.constData();
+    for (int i = 0; i < other.m_words.size(); ++i) dst[i] |= src[i];
+    m_rowCount = qMax(m_rowCount, other.m_rowCount);
+    return *this;
+}
+
+TweetBitmap& TweetBitmap::andNot(const TweetBitmap& other)
+{
+    const int common = qMin(m_words.size(), other.m_words.size());
+    quint64* dst = m_words.data();
+    const quint64* src = other.m_words.constData();
+    for (int i = 0; i < common; ++i) dst[i] &= ~src[i];
+    return *this;
+}
+
+QVector<int> TweetBitmap::rows() const
+{
+    QVector<int> out;
+    out.reserve(count());
+    forEachRow([&out](int row) { out.append(row); });
+    return out;
+}
+
+void TweetBitmap::trimTail()
+{
+    if (m_words.size() != wordCountFor(m_rowCount)) return; // Tail word not materialised yet
+    const int tailBits = m_rowCount % 64;
+    if (tailBits != 0) m_words.last() &= (quint64(1) << tailBits) - 1;
+}
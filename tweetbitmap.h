@@ -0,0 +1,52 @@
+#ifndef TWEETBITMAP_H
+#define TWEETBITMAP_H
+
+#include <QVector>
+#include <QtAlgorithms> // For qPopulationCount, qCountTrailingZeroBits
+
+// Plain bitset over TweetRepository rows, one bit per row. Words past the end of
+// a bitmap read as zero, so postings for rare values only grow as far as their
+// highest row, and word-wise and/or/andNot compile down to tight loops the
+// compiler vectorises. Rows stay stable until the repository compacts, which
+// rebuilds every bitmap.
+class TweetBitmap
+{
+public:
+    TweetBitmap() = default;
+    explicit TweetBitmap(int rowCount, bool filled = false);
+
+    int rowCount() const { return m_rowCount; }
+    void resize(int rowCount); // New rows start cleared
+    void set(int row);          // Grows the bitmap if needed
+    void reset(int row);
+    bool test(int row) const;
+
+    int count() const; // Popcount
+    int intersectionCount(const TweetBitmap& other) const; // count() of *this & other, without building it
+    bool isEmpty() const;
+
+    TweetBitmap& operator&=(const TweetBitmap& other);
+    TweetBitmap& operator|=(const TweetBitmap& other);
+    TweetBitmap& andNot(const TweetBitmap& other);
+
+    template <typename Fn>
+    void forEachRow(Fn&& fn) const
+    {
+        for (int w = 0; w < m_words.size(); ++w) {
+            quint64 word = m_words.at(w);
+            while (word) {
+                fn(w * 64 + qCountTrailingZeroBits(word));
+                word &= word - 1;
+            }
+        }
+    }
+    QVector<int> rows() const;
+
+private:
+    void trimTail(); // Clears bits past m_rowCount in the last word
+
+    QVector<quint64> m_words;
+    int m_rowCount = 0;
+};
+
+#endif // TWEETBITMAP_H
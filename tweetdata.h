@@ -3,6 +3,8 @@
 
 #include <QString>
 #include <QStringList>
+#include <QVector>
+#include "symboltable.h" // For SymbolId
 
 struct TweetData {
     QString id; // Unique identifier (original JSON key)
@@ -15,6 +17,26 @@ struct TweetData {
     QStringList techniqueTags;
     QStringList genericTags; // Original flat 'tags' array
     QStringList ugens;       // Extracted UGens from the code
+
+    // SymbolTable id of author, filled in by TweetRepository, for the author sort order. Tags and
+    // UGens keep no per-tweet id copies: FacetIndex looks their ids up from the lists above when
+    // a row is indexed. The lists hold this tweet's own spelling and order, which display, search
+    // and save reproduce exactly. TweetRepository interns every value, so repeated spellings
+    // share one payload in the table.
+    SymbolId authorId = InvalidSymbolId; // Empty author interns as "Unknown"
+
+    // Derived alongside ugens by TweetRepository::deriveTweetData
+    // Case-folded id, code, description, author and tags, one per line; what the search box matches.
+    // Only carried until the row is indexed: stored rows drop it, and TweetRepository::searchKeys()
+    // keeps it as UTF-8.
+    QString searchKey;
+    size_t codeHash = 0; // qHash of originalCode; process-local, never persisted
+    qint64 publicationDay = 0; // QDate::toJulianDay() of publicationDate; 0 when it does not parse ("unknown")
+
+    // TweetRepository leaves deleted rows in place with an empty id (tombstones) so the
+    // other rows keep their row numbers, which its indexes are keyed by; skip them when
+    // iterating. Row addresses are not stable: see TweetRepository::findTweetById.
+    bool isDeleted() const { return id.isEmpty(); }
 };
 
 #endif // TWEETDATA_H
\ No newline at end of file
@@ -1,9 +1,48 @@
 #include "tweeteditdialog.h"
+#include "sccodeprettyprinter.h"
 #include <QtWidgets> // Includes QLineEdit, QTextEdit, QDialogButtonBox, QVBoxLayout, QFormLayout, QMessageBox
 
+namespace {
+// UTF-8 size of text, without encoding it
+quint32 utf8Length(QStringView text)
+{
+    quint32 length = 0;
+    for (const QChar c : text) {
+        const char16_t u = c.unicode();
+        if (u < 0x80) length += 1;
+        else if (u < 0x800) length += 2;
+        else if (QChar::isSurrogate(u)) length += 2; // Each half of a pair; 4 bytes together
+        else length += 3;
+    }
+    return length;
+}
+
+// UTF-16 position of a UTF-8 byte offset
+int utf16Position(const QByteArray& utf8, quint32 byte)
+{
+    int position = 0;
+    const quint32 end = qMin<quint32>(byte, quint32(utf8.size()));
+    for (quint32 i = 0; i < end; ++i) {
+        const uchar b = uchar(utf8.at(i));
+        if ((b & 0xC0) != 0x80) position += (b >= 0xF0) ? 2 : 1; // Lead bytes only; 4-byte sequences are surrogate pairs
+    }
+    return position;
+}
+}
+
 TweetEditDialog::TweetEditDialog(Mode mode, QWidget *parent)
-    : QDialog(parent), m_mode(mode)
+    : QDialog(parent), m_mode(mode), m_codePrinter(nullptr)
 {
+    m_codePrinter = new SCCodePrettyPrinter();
+    if (!m_codePrinter->initialize()) {
+        qWarning() << "TweetEditDialog: SCCodePrettyPrinter unavailable; no live syntax check or preview.";
+        delete m_codePrinter;
+        m_codePrinter = nullptr;
+    } else {
+        m_codePrinter->setTreeCacheCapacity(0); // Every tree here is the one being edited
+        m_codePrinter->parse(QString());
+    }
+
     setupUi();
 
     if (m_mode == Mode::Add) {
@@ -15,6 +54,12 @@ TweetEditDialog::TweetEditDialog(Mode mode, QWidget *parent)
     setMinimumSize(500, 400); // Set a reasonable minimum size
 }
 
+TweetEditDialog::~TweetEditDialog()
+{
+    disconnect(m_codeTextEdit->document(), nullptr, this, nullptr); // The editor outlives this body
+    delete m_codePrinter;
+}
+
 void TweetEditDialog::setupUi()
 {
     QVBoxLayout *mainLayout = new QVBoxLayout(this);
@@ -49,7 +94,28 @@ void TweetEditDialog::setupUi()
     
     mainLayout->addLayout(formLayout);
     mainLayout->addWidget(new QLabel("SuperCollider Code:"));
-    mainLayout->addWidget(m_codeTextEdit, 1); // Give code editor stretch factor
+
+    m_previewTextEdit = new QTextEdit();
+    m_previewTextEdit->setReadOnly(true);
+    m_previewTextEdit->setAcceptRichText(false);
+    m_previewTextEdit->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    m_previewTextEdit->setPlaceholderText("Formatted preview");
+    QSplitter *codeSplitter = new QSplitter(Qt::Horizontal);
+    codeSplitter->addWidget(m_codeTextEdit);
+    codeSplitter->addWidget(m_previewTextEdit);
+    mainLayout->addWidget(codeSplitter, 1); // Give code editor stretch factor
+
+    m_syntaxStatusLabel = new QLabel();
+    mainLayout->addWidget(m_syntaxStatusLabel);
+
+    if (m_codePrinter) {
+        // contentsChange carries the edited range, which is what lets the printer reparse incrementally
+        connect(m_codeTextEdit->document(), &QTextDocument::contentsChange, this, &TweetEditDialog::onCodeContentsChange);
+        updateCodeDiagnostics();
+    } else {
+        m_previewTextEdit->hide();
+        m_syntaxStatusLabel->hide();
+    }
 
     m_buttonBox = new QDialogButtonBox(QDialogButtonBox::Save | QDialogButtonBox::Cancel);
     connect(m_buttonBox, &QDialogButtonBox::accepted, this, &TweetEditDialog::onAccept); // Connect to custom slot
@@ -59,6 +125,71 @@ void TweetEditDialog::setupUi()
     setLayout(mainLayout);
 }
 
+void TweetEditDialog::onCodeContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    if (!m_codePrinter) return;
+    const QString newCode = m_codeTextEdit->toPlainText();
+    const QString& oldCode = m_codePrinter->currentCode();
+
+    // QTextDocument sometimes reports ranges that include its final paragraph separator (e.g. on
+    // setPlainText); those, and anything else that leaves the tree out of step, get a full parse
+    bool applied = false;
+    if (position >= 0 && charsRemoved >= 0 && charsAdded >= 0 &&
+        position + charsRemoved <= oldCode.size() && position + charsAdded <= newCode.size()) {
+        SCCodePrettyPrinter::TextEdit edit;
+        edit.startByte = utf8Length(QStringView(oldCode).left(position));
+        edit.oldEndByte = edit.startByte + utf8Length(QStringView(oldCode).mid(position, charsRemoved));
+        edit.newText = QStringView(newCode).mid(position, charsAdded).toUtf8();
+        applied = m_codePrinter->applyEdit(edit) && m_codePrinter->currentCode() == newCode;
+    }
+    if (!applied) {
+        m_codePrinter->parse(newCode);
+    }
+    updateCodeDiagnostics();
+}
+
+void TweetEditDialog::updateCodeDiagnostics()
+{
+    if (!m_codePrinter) return;
+
+    const QVector<SCCodePrettyPrinter::SyntaxError> errors = m_codePrinter->syntaxErrors();
+    const QByteArray& codeUtf8 = m_codePrinter->currentCodeUtf8();
+    QList<QTextEdit::ExtraSelection> markers;
+    for (const SCCodePrettyPrinter::SyntaxError& error : errors) {
+        QTextEdit::ExtraSelection marker;
+        marker.format.setUnderlineStyle(QTextCharFormat::WaveUnderline);
+        marker.format.setUnderlineColor(Qt::red);
+        marker.format.setToolTip(error.message);
+        marker.cursor = QTextCursor(m_codeTextEdit->document());
+        const int lastPosition = m_codeTextEdit->document()->characterCount() - 1;
+        int start = utf16Position(codeUtf8, error.startByte);
+        int end = utf16Position(codeUtf8, error.endByte);
+        if (end <= start) { // Missing tokens have no width; mark the character before the gap
+            end = start;
+            start = qMax(0, start - 1);
+        }
+        end = qMax(end, start + 1);
+        marker.cursor.setPosition(qMin(start, lastPosition));
+        marker.cursor.setPosition(qMin(end, lastPosition), QTextCursor::KeepAnchor);
+        markers.append(marker);
+    }
+    m_codeTextEdit->setExtraSelections(markers);
+
+    if (errors.isEmpty()) {
+        m_syntaxStatusLabel->setText("Syntax OK");
+    } else {
+        const SCCodePrettyPrinter::SyntaxError& first = errors.first();
+        QString status = QString("Line %1: %2").arg(first.row + 1).arg(first.message);
+        if (errors.size() > 1) status += QString(" (and %1 more)").arg(errors.size() - 1);
+        m_syntaxStatusLabel->setText(status);
+    }
+
+    QScrollBar *scrollBar = m_previewTextEdit->verticalScrollBar();
+    const int scrollPosition = scrollBar->value();
+    m_previewTextEdit->setPlainText(m_codePrinter->formatCurrentTree());
+    scrollBar->setValue(scrollPosition);
+}
+
 void TweetEditDialog::setTweetData(const TweetData& data)
 {
     m_originalTweetIdForEdit = data.id; // Store original ID for edit mode
@@ -7,10 +7,13 @@
 QT_BEGIN_NAMESPACE
 class QLineEdit;
 class QTextEdit;
+class QLabel;
 class QDialogButtonBox;
 class QFormLayout; // For laying out labels and fields
 QT_END_NAMESPACE
 
+class SCCodePrettyPrinter;
+
 class TweetEditDialog : public QDialog
 {
     Q_OBJECT
@@ -20,6 +23,7 @@ public:
     enum class Mode { Add, Edit };
 
     explicit TweetEditDialog(Mode mode, QWidget *parent = nullptr);
+    ~TweetEditDialog() override;
 
     // Call this before exec() when in Edit mode
     void setTweetData(const TweetData& data);
@@ -31,10 +35,12 @@ public:
 
 private slots:
     void onAccept(); // Custom slot for validation before accepting
+    void onCodeContentsChange(int position, int charsRemoved, int charsAdded); // Incremental reparse of the code
 
 private:
     void setupUi();
     bool validateInput(); // For input validation
+    void updateCodeDiagnostics(); // Error markers, status line and formatted preview from the current tree
 
     Mode m_mode;
     QSet<QString> m_existingTweetIds; // For uniqueness check in Add mode
@@ -51,7 +57,12 @@ private:
     QLineEdit *m_techniqueTagsLineEdit;
     QLineEdit *m_genericTagsLineEdit;
 
+    QTextEdit *m_previewTextEdit;   // Read-only formatted code, follows every keystroke
+    QLabel *m_syntaxStatusLabel;
+
     QDialogButtonBox *m_buttonBox;
+
+    SCCodePrettyPrinter* m_codePrinter; // Holds the live tree of m_codeTextEdit; null if Tree-sitter failed to load
 };
 
 #endif // TWEETEDITDIALOG_H
\ No newline at end of file
@@ -1,168 +1,595 @@
 #include "tweetfilterengine.h"
+#include "symboltable.h"
+#include "tweetbitmap.h"
+#include "fuzzymatcher.h"
+#include "tweetquery.h"
 #include <QDebug>
+#include <QHash>
+#include <QDataStream>
+#include <QMutexLocker>
+#include <QCollator>
+#include <QtConcurrent>
+#include <algorithm> // For std::partial_sort
+#include <limits>
+#include <numeric>   // For std::iota
+#include <utility>   // For std::as_const
 
-TweetFilterEngine::TweetFilterEngine() {}
+namespace {
+// Below this many candidates the substring check alone is cheaper than intersecting trigram
+// postings; refining the previous result while typing usually lands here.
+constexpr int kDirectCheckRows = 4096;
+constexpr int kRowsPerCancelCheck = 2048;
+constexpr int kDefaultCacheRows = 500000; // About 2 MB of row numbers
+// Rows per parallel work item: enough to amortise scheduling, small enough that a chunk's
+// row numbers and results stay in cache and the pool balances uneven (regex-heavy) chunks
+constexpr int kParallelChunkRows = 1024;
+
+bool containsAll(const QStringList& values, const QStringList& required)
+{
+    for (const QString& value : required) {
+        if (!values.contains(value)) return false;
+    }
+    return true;
+}
+
+bool sameValues(const QStringList& a, const QStringList& b)
+{
+    return a.size() == b.size() && containsAll(a, b);
+}
+
+// Calls collect(row, out) for every row, which appends whatever it keeps to out. With at least
+// parallelMinRows rows (and parallelMinRows > 0) the rows are split into chunks evaluated on the
+// global thread pool, each into its own vector; the chunks are concatenated in order, so the
+// output is identical to the single-threaded run. collect must be safe to call concurrently.
+// Returns an empty vector once stopRequested (if set) returns true.
+template <typename T, typename Collect>
+QVector<T> collectRows(const QVector<int>& rows, int parallelMinRows, Collect collect,
+                       const std::function<bool()>& stopRequested)
+{
+    auto stop = [&stopRequested]() { return stopRequested && stopRequested(); };
+    QVector<T> out;
+    if (parallelMinRows <= 0 || rows.size() < parallelMinRows) {
+        for (int i = 0; i < rows.size(); ++i) {
+            if (i > 0 && i % kRowsPerCancelCheck == 0 && stop()) return {};
+            collect(rows.at(i), out);
+        }
+        return out;
+    }
+
+    const int chunkCount = int((rows.size() + kParallelChunkRows - 1) / kParallelChunkRows);
+    QVector<QVector<T>> chunkResults(chunkCount);
+    QVector<int> chunks(chunkCount);
+    std::iota(chunks.begin(), chunks.end(), 0);
+    QtConcurrent::blockingMap(chunks, [&](int chunk) {
+        if (stop()) return;
+        const int end = qMin(int(rows.size()), (chunk + 1) * kParallelChunkRows);
+        QVector<T>& local = chunkResults[chunk]; // Each chunk writes only its own vector
+        for (int i = chunk * kParallelChunkRows; i < end; ++i) collect(rows.at(i), local);
+    });
+    if (stop()) return {};
+
+    qsizetype total = 0;
+    for (const QVector<T>& chunk : chunkResults) total += chunk.size();
+    out.reserve(total);
+    for (const QVector<T>& chunk : chunkResults) out += chunk;
+    return out;
+}
+}
+
+TweetFilterEngine::TweetFilterEngine()
+    : m_resultCache(kDefaultCacheRows)
+{}
+
+void TweetFilterEngine::clearPreviousResult()
+{
+    m_previous = PreviousResult();
+}
+
+FacetCounts TweetFilterEngine::facetCountsFor(const QVector<TweetData>& allTweets, const FacetIndex& facets,
+                                              const QVector<const TweetData*>& results)
+{
+    TweetBitmap rows(allTweets.size());
+    for (const TweetData* tweet : results) rows.set(int(tweet - allTweets.constData()));
+    FacetCounts counts;
+    counts.authors = facets.countsWithin(FacetKind::Author, rows);
+    counts.sonicTags = facets.countsWithin(FacetKind::SonicTag, rows);
+    counts.techniqueTags = facets.countsWithin(FacetKind::TechniqueTag, rows);
+    counts.ugens = facets.countsWithin(FacetKind::Ugen, rows);
+    return counts;
+}
+
+TweetFilterEngine::CacheStats TweetFilterEngine::cacheStats() const
+{
+    QMutexLocker locker(&m_cacheMutex);
+    CacheStats stats;
+    stats.hits = m_cacheHits;
+    stats.misses = m_cacheMisses;
+    stats.entries = m_resultCache.count();
+    return stats;
+}
+
+void TweetFilterEngine::setCacheCapacity(int maxRows)
+{
+    QMutexLocker locker(&m_cacheMutex);
+    m_resultCache.setMaxCost(qMax(0, maxRows));
+}
+
+void TweetFilterEngine::clearCache()
+{
+    QMutexLocker locker(&m_cacheMutex);
+    m_resultCache.clear();
+}
+
+QByteArray TweetFilterEngine::cacheKey(const FilterCriteria& criteria)
+{
+    // Checked values are sets, so their order does not matter; favorites only matter when filtered on
+    auto canonical = [](QStringList values) {
+        values.sort();
+        values.removeDuplicates();
+        return values;
+    };
+    QByteArray key;
+    QDataStream out(&key, QIODevice::WriteOnly);
+    out << criteria.repositoryVersion
+        << (criteria.favoritesOnly ? criteria.favoritesVersion : quint64(0))
+        << criteria.searchText.trimmed()
+        << criteria.favoritesOnly << criteria.useAndLogic << criteria.verifyUgensInSource
+        << criteria.fuzzyFallback << qint32(criteria.maxFuzzyResults)
+        << qint32(criteria.sortMode) << qint32(criteria.sortLimit)
+        << canonical(criteria.checkedAuthors) << canonical(criteria.checkedSonicTags)
+        << canonical(criteria.checkedTechniqueTags) << canonical(criteria.checkedUgens);
+    return key;
+}
+
+const QHash<SymbolId, int>& TweetFilterEngine::authorRanks(const FacetIndex& facets, quint64 repositoryVersion)
+{
+    if (m_authorRanksValid && m_authorRanksVersion == repositoryVersion) return m_authorRanks;
+
+    // A few hundred names: collate each once, then rows compare plain ints
+    QCollator collator;
+    collator.setCaseSensitivity(Qt::CaseInsensitive);
+    collator.setNumericMode(true);
+    struct Named {
+        QCollatorSortKey key;
+        SymbolId id;
+    };
+    QVector<Named> authors;
+    const QHash<SymbolId, int>& counts = facets.counts(FacetKind::Author);
+    authors.reserve(counts.size());
+    for (auto it = counts.constBegin(); it != counts.constEnd(); ++it) {
+        Named named { collator.sortKey(SymbolTable::instance().text(it.key())), it.key() };
+        authors.append(named);
+    }
+    std::sort(authors.begin(), authors.end(), [](const Named& a, const Named& b) {
+        return a.key.compare(b.key) < 0;
+    });
+    m_authorRanks.clear();
+    m_authorRanks.reserve(authors.size());
+    for (int rank = 0; rank < authors.size(); ++rank) m_authorRanks.insert(authors.at(rank).id, rank);
+    m_authorRanksVersion = repositoryVersion;
+    m_authorRanksValid = true;
+    return m_authorRanks;
+}
+
+void TweetFilterEngine::sortResults(QVector<const TweetData*>& results, const QVector<TweetData>& allTweets,
+                                    const FacetIndex& facets, const SearchKeyStore& searchKeys,
+                                    const QVector<QByteArray>& utf8Terms, const FilterCriteria& criteria)
+{
+    if (criteria.sortMode == TweetSortMode::Collection || results.size() < 2) return;
+    if (criteria.sortMode == TweetSortMode::Relevance && utf8Terms.isEmpty()) return; // Nothing to score
+
+    // One integer key per result, smaller first, computed up front so the sort itself never
+    // touches strings; the row breaks ties, which keeps collection order among equals
+    struct Entry {
+        qint64 key;
+        int row;
+        bool operator<(const Entry& other) const { return key != other.key ? key < other.key : row < other.row; }
+    };
+    const QHash<SymbolId, int>* ranks = criteria.sortMode == TweetSortMode::Author
+        ? &authorRanks(facets, criteria.repositoryVersion) : nullptr;
+    QVector<Entry> entries;
+    entries.reserve(results.size());
+    for (const TweetData* tweet : std::as_const(results)) {
+        const int row = int(tweet - allTweets.constData());
+        qint64 key = 0;
+        switch (criteria.sortMode) {
+        case TweetSortMode::Relevance: {
+            // The key starts with the folded id; a hit there outweighs any number of hits elsewhere
+            const QByteArrayView text = searchKeys.key(row);
+            const qsizetype idEnd = text.indexOf('\n');
+            const QByteArrayView id = idEnd < 0 ? text : text.first(idEnd);
+            qint64 score = 0;
+            for (const QByteArray& term : utf8Terms) {
+                if (id.contains(term)) score += 1000;
+                int occurrences = 0;
+                for (qsizetype at = text.indexOf(term); at >= 0 && occurrences < 100; at = text.indexOf(term, at + 1)) {
+                    ++occurrences;
+                }
+                score += occurrences;
+            }
+            key = -score;
+            break;
+        }
+        case TweetSortMode::CodeLength:
+            key = tweet->originalCode.size();
+            break;
+        case TweetSortMode::UgenCount:
+            key = tweet->ugens.size();
+            break;
+        case TweetSortMode::Author:
+            key = ranks->value(tweet->authorId, ranks->size());
+            break;
+        case TweetSortMode::Date:
+            key = tweet->publicationDay != 0 ? -tweet->publicationDay : std::numeric_limits<qint64>::max();
+            break;
+        case TweetSortMode::Collection:
+            break;
+        }
+        Entry entry { key, row };
+        entries.append(entry);
+    }
+
+    if (criteria.sortLimit > 0 && criteria.sortLimit < entries.size()) {
+        std::partial_sort(entries.begin(), entries.begin() + criteria.sortLimit, entries.end());
+    } else {
+        std::sort(entries.begin(), entries.end());
+    }
+    for (int i = 0; i < entries.size(); ++i) results[i] = &allTweets.at(entries.at(i).row);
+}
+
+void TweetFilterEngine::rememberResult(const FilterCriteria& criteria, const QStringList& searchTerms,
+                                       bool queryMode, const TweetBitmap& exactRows)
+{
+    m_previous.valid = true;
+    m_previous.criteria = criteria;
+    m_previous.criteria.favoriteTweetIds = nullptr; // Covered by favoritesVersion; the set may go away
+    m_previous.searchTerms = searchTerms;
+    m_previous.queryMode = queryMode;
+    m_previous.rows = exactRows;
+}
+
+bool TweetFilterEngine::narrows(const PreviousResult& previous, const FilterCriteria& next,
+                                const QStringList& nextTerms, bool nextQueryMode)
+{
+    if (!previous.valid) return false;
+    const FilterCriteria& old = previous.criteria;
+    if (old.repositoryVersion != next.repositoryVersion || old.favoritesVersion != next.favoritesVersion) {
+        return false; // Rows or favorites changed underneath the old result
+    }
+    if (old.useAndLogic != next.useAndLogic || old.verifyUgensInSource != next.verifyUgensInSource) return false;
+    if (old.favoritesOnly && !next.favoritesOnly) return false;
+
+    if (next.useAndLogic) {
+        // Every extra sonic/technique/UGen is one more intersection
+        if (!containsAll(next.checkedSonicTags, old.checkedSonicTags) ||
+            !containsAll(next.checkedTechniqueTags, old.checkedTechniqueTags) ||
+            !containsAll(next.checkedUgens, old.checkedUgens)) {
+            return false;
+        }
+        // Authors are a union, so fewer of them narrow; none at all means any author
+        if (!old.checkedAuthors.isEmpty() &&
+            (next.checkedAuthors.isEmpty() || !containsAll(old.checkedAuthors, next.checkedAuthors))) {
+            return false;
+        }
+    } else {
+        // OR: any change to a non-empty selection can add rows
+        const bool oldAny = !old.checkedAuthors.isEmpty() || !old.checkedSonicTags.isEmpty() ||
+                            !old.checkedTechniqueTags.isEmpty() || !old.checkedUgens.isEmpty();
+        if (oldAny && (!sameValues(old.checkedAuthors, next.checkedAuthors) ||
+                       !sameValues(old.checkedSonicTags, next.checkedSonicTags) ||
+                       !sameValues(old.checkedTechniqueTags, next.checkedTechniqueTags) ||
+                       !sameValues(old.checkedUgens, next.checkedUgens))) {
+            return false;
+        }
+    }
+
+    // A query only narrows itself; plain terms narrow when each old term lives on inside a new
+    // one ("sin" -> "sinosc", or "sin" -> "sin drone")
+    if (previous.queryMode || nextQueryMode) {
+        return previous.queryMode && nextQueryMode && old.searchText.trimmed() == next.searchText.trimmed();
+    }
+    for (const QString& oldTerm : previous.searchTerms) {
+        bool kept = false;
+        for (const QString& newTerm : nextTerms) {
+            if (newTerm.contains(oldTerm)) { kept = true; break; }
+        }
+        if (!kept) return false;
+    }
+    return true;
+}
 
 QVector<const TweetData*> TweetFilterEngine::filterTweets(
     const QVector<TweetData>& allTweets,
-    const FilterCriteria& criteria) const
+    const FacetIndex& facets,
+    const TrigramIndex& trigrams,
+    const SearchKeyStore& searchKeys,
+    const FilterCriteria& criteria,
+    FilterReport* report,
+    const std::function<bool()>& isCancelled)
 {
     QVector<const TweetData*> filteredResults;
+    FilterReport localReport; // The cache keeps the report along with the rows
+    if (!report) report = &localReport;
+    auto cancelled = [&]() {
+        if (!isCancelled || !isCancelled()) return false;
+        report->cancelled = true;
+        return true;
+    };
 
-    // Pre-compile Regexes for checked UGens
-    QList<QRegularExpression> ugenMethodCheckRegexes;
-    QList<QRegularExpression> ugenFuncCheckRegexes;
-    if (!criteria.checkedUgens.isEmpty()) {
-        for(const QString& ugen : criteria.checkedUgens) {
-            QString escapedUgen = QRegularExpression::escape(ugen);
-            ugenMethodCheckRegexes.append(QRegularExpression(QString(R"(\b%1\b(?:\.(?:ar|kr|ir|new)\b|\())").arg(escapedUgen)));
-            ugenFuncCheckRegexes.append(QRegularExpression(QString(R"(\b(?:ar|kr|ir|new)\b\s*\(\s*%1\b)").arg(escapedUgen)));
+    const QByteArray key = cacheKey(criteria);
+    CachedResult cached;
+    bool cacheHit = false;
+    {
+        QMutexLocker locker(&m_cacheMutex);
+        if (criteria.repositoryVersion != m_cacheRepositoryVersion) {
+            m_resultCache.clear();
+            m_cacheRepositoryVersion = criteria.repositoryVersion;
+        }
+        if (const CachedResult* entry = m_resultCache.object(key)) { // Also marks it most recently used
+            cached = *entry;
+            cacheHit = true;
+            ++m_cacheHits;
+        } else {
+            ++m_cacheMisses;
+        }
+    }
+    if (cacheHit) {
+        filteredResults.reserve(cached.rows.size());
+        TweetBitmap exactRows(allTweets.size());
+        for (int row : cached.rows) {
+            filteredResults.append(&allTweets.at(row));
+            if (!cached.report.usedFuzzyMatch) exactRows.set(row);
         }
+        *report = cached.report;
+        const QStringList searchTerms = cached.report.usedQuery
+            ? QStringList()
+            : criteria.searchText.toCaseFolded().split(QLatin1Char(' '), Qt::SkipEmptyParts);
+        rememberResult(criteria, searchTerms, cached.report.usedQuery, exactRows);
+        return filteredResults;
     }
 
+    // UGens are matched through the postings built from TweetData::ugens at load time. Only the
+    // opt-in "verify in source" mode compiles patterns, one per checked UGen covering both the
+    // method (SinOsc.ar) and function (ar(SinOsc)) spellings, and runs them on the facet survivors.
+    const bool verifyUgens = criteria.verifyUgensInSource && !criteria.checkedUgens.isEmpty();
+    QList<QRegularExpression> ugenSourceRegexes;
+    if (verifyUgens) {
+        for (const QString& ugen : criteria.checkedUgens) {
+            const QString escapedUgen = QRegularExpression::escape(ugen);
+            ugenSourceRegexes.append(QRegularExpression(
+                QString(R"(\b%1\b(?:\.(?:ar|kr|ir|new)\b|\()|\b(?:ar|kr|ir|new)\b\s*\(\s*%1\b)").arg(escapedUgen)));
+        }
+    }
+    for (QRegularExpression& regex : ugenSourceRegexes) regex.optimize(); // Compile now, not racily on first match
+    auto ugenFoundInSource = [&](int i, const TweetData& tweet) {
+        return ugenSourceRegexes.at(i).match(tweet.originalCode).hasMatch();
+    };
+
+    // Resolve checked values to SymbolTable ids once so the facets are plain posting lookups.
+    // A value no tweet uses has no postings, so it matches nothing.
+    auto resolveIds = [](const QStringList& values) {
+        QVector<SymbolId> ids;
+        ids.reserve(values.size());
+        for (const QString& value : values) ids.append(SymbolTable::instance().lookup(value));
+        return ids;
+    };
+    const QVector<SymbolId> authorIds = resolveIds(criteria.checkedAuthors);
+    const QVector<SymbolId> sonicIds = resolveIds(criteria.checkedSonicTags);
+    const QVector<SymbolId> techniqueIds = resolveIds(criteria.checkedTechniqueTags);
+    const QVector<SymbolId> ugenIds = resolveIds(criteria.checkedUgens);
+    // Every term must occur in TweetData::searchKey; "feedback drone" finds both words anywhere
+    QStringList searchTerms = criteria.searchText.toCaseFolded().split(QLatin1Char(' '), Qt::SkipEmptyParts);
+    TweetQuery query;
+    const bool queryMode = TweetQuery::looksLikeQuery(criteria.searchText) && query.parse(criteria.searchText);
+    if (queryMode) {
+        searchTerms.clear(); // The query handles the text itself
+    } else if (TweetQuery::looksLikeQuery(criteria.searchText)) {
+        report->queryError = query.errorString();
+    }
+    report->usedQuery = queryMode;
+
     qDebug() << "Filtering with criteria - Search:" << criteria.searchText
              << "FavsOnly:" << criteria.favoritesOnly
              << "Logic:" << (criteria.useAndLogic ? "AND" : "OR")
              << "Authors:" << criteria.checkedAuthors
              << "Sonics:" << criteria.checkedSonicTags
              << "Techniques:" << criteria.checkedTechniqueTags
-             << "Ugens:" << criteria.checkedUgens;
+             << "Ugens:" << criteria.checkedUgens
+             << "VerifyUgens:" << verifyUgens;
 
+    const bool refining = narrows(m_previous, criteria, searchTerms, queryMode);
+    report->refinedPrevious = refining;
 
-    for (const auto& tweet : allTweets) {
-        bool passesFilter = true;
-
-        // 1. Global Search (Tweet ID/Name)
-        if (!criteria.searchText.isEmpty() && !tweet.id.contains(criteria.searchText, Qt::CaseInsensitive)) {
-            passesFilter = false;
+    // 1. Checkbox facets: word-wise intersections/unions of the per-value postings
+    TweetBitmap candidates = facets.liveRows(); // Tombstones never make it in
+    TweetBitmap ugenOnlyMatches;                // OR logic: rows that matched through a UGen posting alone
+    bool anyTagCheckboxesSelected = !authorIds.isEmpty() ||
+                                  !sonicIds.isEmpty() ||
+                                  !techniqueIds.isEmpty() ||
+                                  !ugenIds.isEmpty();
+    if (anyTagCheckboxesSelected) {
+        if (criteria.useAndLogic) { // AND Logic
+            // Authors: a tweet has one author, so it must be one of the checked ones
+            if (!authorIds.isEmpty()) {
+                TweetBitmap authorRows;
+                for (SymbolId id : authorIds) authorRows |= facets.postings(FacetKind::Author, id);
+                candidates &= authorRows;
+            }
+            // Sonics, techniques, UGens: tweet must carry every checked value
+            for (SymbolId id : sonicIds) candidates &= facets.postings(FacetKind::SonicTag, id);
+            for (SymbolId id : techniqueIds) candidates &= facets.postings(FacetKind::TechniqueTag, id);
+            for (SymbolId id : ugenIds) candidates &= facets.postings(FacetKind::Ugen, id);
+        } else { // OR Logic (Tweet must match ANY checked item in ANY active category)
+            TweetBitmap anyRows;
+            for (SymbolId id : authorIds) anyRows |= facets.postings(FacetKind::Author, id);
+            for (SymbolId id : sonicIds) anyRows |= facets.postings(FacetKind::SonicTag, id);
+            for (SymbolId id : techniqueIds) anyRows |= facets.postings(FacetKind::TechniqueTag, id);
+            TweetBitmap ugenRows;
+            for (SymbolId id : ugenIds) ugenRows |= facets.postings(FacetKind::Ugen, id);
+            if (verifyUgens) {
+                ugenOnlyMatches = ugenRows;
+                ugenOnlyMatches.andNot(anyRows);
+            }
+            anyRows |= ugenRows;
+            candidates &= anyRows;
         }
+    }
+
+    // 2. Search terms: intersect with each term's trigram candidates (terms under three
+    //    characters cannot narrow anything and are left to the substring check below).
+    //    A query runs its own plan over the facet survivors instead. When the criteria only
+    //    narrow the previous call's, its exact rows bound the result from the start.
+    const TweetBitmap facetCandidates = candidates; // Kept for the fuzzy fallback
+    if (refining) candidates &= m_previous.rows;
+    if (cancelled()) return filteredResults;
+    if (queryMode) {
+        candidates = query.evaluate(facets, trigrams, searchKeys, candidates,
+                                    query.isExplain() ? &report->explain : nullptr);
+        if (cancelled()) return filteredResults;
+    }
+    QVector<int> termRows;
+    const bool checkDirectly = candidates.count() <= kDirectCheckRows;
+    for (const QString& term : searchTerms) {
+        if (candidates.isEmpty() || checkDirectly) break;
+        if (!trigrams.candidates(term, termRows)) continue;
+        TweetBitmap termBitmap;
+        for (int row : termRows) termBitmap.set(row);
+        candidates &= termBitmap;
+    }
 
-        // 2. Favorite Filter
-        if (passesFilter && criteria.favoritesOnly) {
+    // Favorites and UGen verification apply to exact and fuzzy results alike. Read-only, so it may
+    // run on several pool threads at once.
+    auto passesRowChecks = [&](int row, const TweetData& tweet) {
+        // Favorite Filter
+        if (criteria.favoritesOnly) {
             if (!criteria.favoriteTweetIds || !criteria.favoriteTweetIds->contains(tweet.id)) {
-                passesFilter = false;
+                return false;
             }
         }
 
-        // Proceed to tag filters only if passed global filters
-        if (passesFilter) {
-            bool anyTagCheckboxesSelected = !criteria.checkedAuthors.isEmpty() ||
-                                          !criteria.checkedSonicTags.isEmpty() ||
-                                          !criteria.checkedTechniqueTags.isEmpty() ||
-                                          !criteria.checkedUgens.isEmpty();
-
-            if (anyTagCheckboxesSelected) {
-                if (criteria.useAndLogic) { // AND Logic
-                    // Check Authors
-                    if (!criteria.checkedAuthors.isEmpty()) {
-                        bool authorMatch = false; // Must match one of the checked authors if AND logic is per category
-                                                  // If "Match All" means all *categories* must have a match, this is different.
-                                                  // Assuming "Match All" means *all selected items within a category, and across categories*.
-                        for (const QString& reqAuthor : criteria.checkedAuthors) {
-                             if ((reqAuthor == "Unknown" && tweet.author.isEmpty()) || (tweet.author == reqAuthor)) {
-                                 authorMatch = true; // This tweet matches at least one selected author.
-                                 break;             // For AND logic on this category, this is enough.
-                             }
-                        }
-                        // If "Match All" means tweet must match ALL selected authors:
-                        // for (const QString& reqAuthor : criteria.checkedAuthors) {
-                        //     if (!((reqAuthor == "Unknown" && tweet.author.isEmpty()) || (tweet.author == reqAuthor))) {
-                        //         passesFilter = false; break;
-                        //     }
-                        // }
-                        // Sticking to: tweet must contain ALL selected authors.
-                        for (const QString& reqAuthor : criteria.checkedAuthors) {
-                            bool currentAuthorMatch = (reqAuthor == "Unknown") ? tweet.author.isEmpty() : (tweet.author == reqAuthor);
-                            // This interpretation of AND logic means if 'Author A' AND 'Author B' are checked,
-                            // the tweet's author must be 'Author A' AND 'Author B', which is impossible for a single field.
-                            // More likely interpretation for "Match All" (AND):
-                            // Tweet must match (Author criteria) AND (Sonic criteria) AND (Technique criteria) AND (UGen criteria)
-                            // Where (Author criteria) means: if authors are checked, tweet's author must be one of them.
-                            // Let's assume the current UI means: if checkedAuthors is ["A", "B"], a tweet by "A" passes, a tweet by "B" passes.
-                            // The "Match All" toggle then means it must pass the Author block AND the Sonic block, etc.
-
-                            // Simpler: If authors are selected, the tweet's author MUST be in the selected list.
-                            if (!criteria.checkedAuthors.contains(tweet.author) && !(tweet.author.isEmpty() && criteria.checkedAuthors.contains("Unknown"))) {
-                                passesFilter = false; // If author not in list, AND logic fails here for author block.
-                            }
-                        }
-                        if (!passesFilter) goto nextTweet; // Optimization
-                    }
-
-
-                    // Check Sonics
-                    if (!criteria.checkedSonicTags.isEmpty()) {
-                        for (const QString& reqSonic : criteria.checkedSonicTags) {
-                            if (!tweet.sonicTags.contains(reqSonic, Qt::CaseInsensitive)) {
-                                passesFilter = false; break;
-                            }
-                        }
-                        if (!passesFilter) goto nextTweet;
-                    }
-
-                    // Check Techniques
-                    if (!criteria.checkedTechniqueTags.isEmpty()) {
-                        for (const QString& reqTechnique : criteria.checkedTechniqueTags) {
-                            if (!tweet.techniqueTags.contains(reqTechnique, Qt::CaseInsensitive)) {
-                                passesFilter = false; break;
-                            }
-                        }
-                        if (!passesFilter) goto nextTweet;
-                    }
-                    
-                    // Check UGens (Tweet must contain ALL checked UGens)
-                    if (!criteria.checkedUgens.isEmpty()) {
-                        for (int i = 0; i < criteria.checkedUgens.size(); ++i) {
-                           if (i >= ugenMethodCheckRegexes.size() || i >= ugenFuncCheckRegexes.size()) {
-                               qWarning() << "Regex list size mismatch for UGens!"; passesFilter = false; break;
-                           }
-                           bool ugenFoundInTweet = ugenMethodCheckRegexes[i].match(tweet.originalCode).hasMatch() ||
-                                                 ugenFuncCheckRegexes[i].match(tweet.originalCode).hasMatch();
-                           if (!ugenFoundInTweet) {
-                               passesFilter = false; break;
-                           }
-                       }
-                       if (!passesFilter) goto nextTweet;
-                    }
-
-                } else { // OR Logic (Tweet must match ANY checked item in ANY active category)
-                    bool orMatchFound = false;
-                    if (!criteria.checkedAuthors.isEmpty()) {
-                        if (criteria.checkedAuthors.contains(tweet.author) || (tweet.author.isEmpty() && criteria.checkedAuthors.contains("Unknown"))) {
-                            orMatchFound = true;
-                        }
-                    }
-                    if (!orMatchFound && !criteria.checkedSonicTags.isEmpty()) {
-                        for (const QString& reqSonic : criteria.checkedSonicTags) {
-                            if (tweet.sonicTags.contains(reqSonic, Qt::CaseInsensitive)) {
-                                orMatchFound = true; break;
-                            }
-                        }
-                    }
-                    if (!orMatchFound && !criteria.checkedTechniqueTags.isEmpty()) {
-                        for (const QString& reqTechnique : criteria.checkedTechniqueTags) {
-                            if (tweet.techniqueTags.contains(reqTechnique, Qt::CaseInsensitive)) {
-                                orMatchFound = true; break;
-                            }
-                        }
-                    }
-                    if (!orMatchFound && !criteria.checkedUgens.isEmpty()) {
-                        for (int i = 0; i < criteria.checkedUgens.size(); ++i) {
-                            if (i >= ugenMethodCheckRegexes.size() || i >= ugenFuncCheckRegexes.size()) { qWarning() << "Regex list size mismatch for UGens!"; break; }
-                            if (ugenMethodCheckRegexes[i].match(tweet.originalCode).hasMatch() || ugenFuncCheckRegexes[i].match(tweet.originalCode).hasMatch()) {
-                                orMatchFound = true; break;
-                            }
-                        }
-                    }
-                    if (!orMatchFound) passesFilter = false;
-                } // End OR Logic
-            } // End if (anyTagCheckboxesSelected)
-        } // End if (passes global filters)
-
-      nextTweet:;
-        if (passesFilter) {
-            filteredResults.append(&tweet);
+        // Verify mode: the postings are case-folded, so confirm the exact spelling in the source code
+        if (verifyUgens) {
+            if (criteria.useAndLogic) {
+                for (int i = 0; i < criteria.checkedUgens.size(); ++i) {
+                    if (!ugenFoundInSource(i, tweet)) return false;
+                }
+            } else if (ugenOnlyMatches.test(row)) {
+                bool orMatchFound = false;
+                for (int i = 0; !orMatchFound && i < criteria.checkedUgens.size(); ++i) {
+                    orMatchFound = ugenFoundInSource(i, tweet);
+                }
+                if (!orMatchFound) return false;
+            }
         }
+        return true;
+    };
+
+    // 3. Per-row checks, only on the rows the indexes left; chunked over the thread pool when
+    //    there are enough of them
+    QVector<QByteArray> utf8Terms; // Encoded once; the keys they are searched in are UTF-8 too
+    utf8Terms.reserve(searchTerms.size());
+    for (const QString& term : searchTerms) utf8Terms.append(term.toUtf8());
+    const QVector<int> matchedRows = collectRows<int>(candidates.rows(), criteria.parallelMinRows,
+        [&](int row, QVector<int>& out) {
+            // Global Search: trigram candidates still need the real substring match
+            for (const QByteArray& term : utf8Terms) {
+                if (!searchKeys.contains(row, term)) return;
+            }
+            if (passesRowChecks(row, allTweets.at(row))) out.append(row);
+        }, isCancelled);
+    if (cancelled()) return {}; // Partial: neither delivered nor remembered
+
+    filteredResults.reserve(matchedRows.size());
+    TweetBitmap exactRows(allTweets.size());
+    for (int row : matchedRows) {
+        filteredResults.append(&allTweets.at(row));
+        exactRows.set(row);
+    }
+
+    rememberResult(criteria, searchTerms, queryMode, exactRows);
+
+    if (filteredResults.isEmpty() && criteria.fuzzyFallback && !searchTerms.isEmpty()) {
+        filteredResults = fuzzyMatches(allTweets, facets, facetCandidates, searchTerms.join(QLatin1Char(' ')),
+                                       criteria.maxFuzzyResults, criteria.parallelMinRows, passesRowChecks,
+                                       isCancelled);
+        cancelled(); // Flags the report if the scan above gave up
+        report->usedFuzzyMatch = !filteredResults.isEmpty();
+        if (report->cancelled) return {};
+    }
+
+    // Fuzzy results already come best first, which is what relevance asks for
+    if (!(report->usedFuzzyMatch && criteria.sortMode == TweetSortMode::Relevance)) {
+        sortResults(filteredResults, allTweets, facets, searchKeys, utf8Terms, criteria);
     }
+
+    CachedResult* entry = new CachedResult;
+    entry->rows.reserve(filteredResults.size());
+    for (const TweetData* tweet : filteredResults) entry->rows.append(int(tweet - allTweets.constData()));
+    entry->report = *report;
+    entry->report.refinedPrevious = false;
+    QMutexLocker locker(&m_cacheMutex);
+    m_resultCache.insert(key, entry, int(entry->rows.size()) + 1); // Takes ownership, even if too big to keep
     return filteredResults;
-}
\ No newline at end of file
+}
+
+QVector<const TweetData*> TweetFilterEngine::fuzzyMatches(
+    const QVector<TweetData>& allTweets,
+    const FacetIndex& facets,
+    const TweetBitmap& candidates,
+    const QString& foldedPattern,
+    int maxResults,
+    int parallelMinRows,
+    const std::function<bool(int, const TweetData&)>& rowFilter,
+    const std::function<bool()>& isCancelled) const
+{
+    QVector<const TweetData*> results;
+    const FuzzyMatcher matcher(foldedPattern);
+    if (matcher.patternLength() < 3 || maxResults <= 0) return results; // Too short to rank meaningfully
+    const int budget = matcher.maxDistance();
+
+    // UGen names: a few hundred distinct values, each scored once, then spread over their postings
+    QHash<int, int> ugenDistanceByRow;
+    const QHash<SymbolId, int>& ugenCounts = facets.counts(FacetKind::Ugen);
+    for (auto it = ugenCounts.constBegin(); it != ugenCounts.constEnd(); ++it) {
+        const int distance = matcher.editDistance(SymbolTable::instance().text(it.key()).toCaseFolded());
+        if (distance > budget) continue;
+        TweetBitmap rows = facets.postings(FacetKind::Ugen, it.key());
+        rows &= candidates;
+        rows.forEachRow([&](int row) {
+            auto existing = ugenDistanceByRow.find(row);
+            if (existing == ugenDistanceByRow.end()) ugenDistanceByRow.insert(row, distance);
+            else if (distance < existing.value()) existing.value() = distance;
+        });
+    }
+
+    struct Hit {
+        int distance;
+        int lengthDelta; // Prefer ids about as long as what was typed
+        int row;
+    };
+    // Bit-parallel matching per id is the costliest scan in the engine, so it is chunked too
+    QVector<Hit> hits = collectRows<Hit>(candidates.rows(), parallelMinRows,
+        [&](int row, QVector<Hit>& out) {
+            const TweetData& tweet = allTweets.at(row);
+            const QString foldedId = tweet.id.toCaseFolded(); // No copy when the id is already folded
+
+            int distance = matcher.substringDistance(foldedId);
+            distance = qMin(distance, ugenDistanceByRow.value(row, distance));
+            if (distance > budget || !rowFilter(row, tweet)) return;
+            Hit hit { distance, int(qAbs(foldedId.size() - matcher.patternLength())), row };
+            out.append(hit);
+        }, isCancelled);
+    if (isCancelled && isCancelled()) return results;
+
+    auto better = [&allTweets](const Hit& a, const Hit& b) {
+        if (a.distance != b.distance) return a.distance < b.distance;
+        if (a.lengthDelta != b.lengthDelta) return a.lengthDelta < b.lengthDelta;
+        return allTweets.at(a.row).id < allTweets.at(b.row).id;
+    };
+    const int keep = qMin(maxResults, int(hits.size()));
+    std::partial_sort(hits.begin(), hits.begin() + keep, hits.end(), better);
+
+    results.reserve(keep);
+    for (int i = 0; i < keep; ++i) results.append(&allTweets.at(hits.at(i).row));
+    return results;
+}
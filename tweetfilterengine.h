@@ -2,21 +2,66 @@
 #define TWEETFILTERENGINE_H
 
 #include "tweetdata.h" // For TweetData
+#include "facetindex.h"
+#include "trigramindex.h"
+#include "searchkeystore.h"
+#include "tweetbitmap.h"
 #include <QVector>
 #include <QStringList>
 #include <QSet> // For passing favorite IDs
 #include <QRegularExpression>
+#include <QCache>
+#include <QMutex>
+#include <functional>
 
 
+// Result order. Every mode breaks ties by collection order, which is also the Collection mode.
+enum class TweetSortMode {
+    Collection,  // Repository row order (file order, then additions)
+    Relevance,   // Search terms in the id first, then by number of occurrences; plain search text only
+    CodeLength,  // Shortest code first
+    UgenCount,   // Fewest distinct UGens first
+    Author,      // Locale-aware, case-insensitive
+    Date         // Newest first; unparsable dates ("unknown") last
+};
+
 struct FilterCriteria {
-    QString searchText;
-    bool favoritesOnly;
-    const QSet<QString>* favoriteTweetIds; // Pointer to the set from FavoritesManager
-    bool useAndLogic;
+    QString searchText; // Whitespace-separated terms, each a case-insensitive substring of id, code, description, author or tags
+    bool favoritesOnly = false;
+    const QSet<QString>* favoriteTweetIds = nullptr; // Pointer to the set from FavoritesManager
+    bool useAndLogic = true;
     QStringList checkedAuthors;
     QStringList checkedSonicTags;
     QStringList checkedTechniqueTags;
     QStringList checkedUgens;
+    bool verifyUgensInSource = false; // Also regex-check checked UGens against originalCode (slow, opt-in)
+    bool fuzzyFallback = true;        // No exact hit: rank ids and UGen names by typo distance instead
+    int maxFuzzyResults = 100;
+    int parallelMinRows = 8192;       // Fewer rows to check than this stay on the calling thread (<= 0: never parallel)
+    TweetSortMode sortMode = TweetSortMode::Collection;
+    int sortLimit = 0;                // > 0: only the first sortLimit results are ordered (partial sort); the rest follow in no set order
+    // Versions of the rows and favorites the criteria were built against; the engine only
+    // refines its previous result while both are unchanged
+    quint64 repositoryVersion = 0;
+    quint64 favoritesVersion = 0;
+};
+
+// What filterTweets did with the search text, for the status bar
+struct FilterReport {
+    bool usedFuzzyMatch = false; // Results are the closest ids/UGen names, best first
+    bool usedQuery = false;      // searchText was run as a TweetQuery
+    QString queryError;          // Looked like a query but did not parse; searched as plain text instead
+    QStringList explain;         // EXPLAIN plan lines, when requested
+    bool refinedPrevious = false; // Only narrowed the last call's criteria, so only its results were checked
+    bool cancelled = false;       // isCancelled fired; the (empty) result means nothing
+};
+
+// Per facet value, how many of the current results carry it (display spelling -> count)
+struct FacetCounts {
+    QHash<QString, int> authors;
+    QHash<QString, int> sonicTags;
+    QHash<QString, int> techniqueTags;
+    QHash<QString, int> ugens;
 };
 
 class TweetFilterEngine
@@ -24,10 +69,90 @@ class TweetFilterEngine
 public:
     TweetFilterEngine();
 
+    // Checkbox facets are answered from the repository's FacetIndex postings and search terms
+    // from its TrigramIndex (both over rows of allTweets); the surviving rows are then verified
+    // with byte searches in its SearchKeyStore.
+    // Search text using fields or AND/OR/NOT runs as a TweetQuery. Exact results come back in
+    // FilterCriteria::sortMode order; when plain search text matches nothing, the closest
+    // ids/UGen names come back instead (see FilterReport::usedFuzzyMatch), best first unless
+    // another sort mode is chosen.
+    // The exact result is remembered: when the next criteria can only narrow it (a search term
+    // extended while typing, another tag checked) just those rows are re-checked.
+    // Not thread-safe, but may run on any one thread at a time. isCancelled is polled between
+    // stages and every few thousand rows; once it returns true the call gives up early.
     QVector<const TweetData*> filterTweets(
         const QVector<TweetData>& allTweets,
-        const FilterCriteria& criteria
+        const FacetIndex& facets,
+        const TrigramIndex& trigrams,
+        const SearchKeyStore& searchKeys,
+        const FilterCriteria& criteria,
+        FilterReport* report = nullptr,
+        const std::function<bool()>& isCancelled = nullptr
+    );
+    void clearPreviousResult(); // Forces the next call to evaluate from scratch
+
+    // Counts for every facet value within results (rows of allTweets): the results become one
+    // bitmap, and each value costs a single AND+popcount pass over its postings. Thread-safe.
+    static FacetCounts facetCountsFor(const QVector<TweetData>& allTweets, const FacetIndex& facets,
+                                      const QVector<const TweetData*>& results);
+
+    // Recent results are kept in an LRU cache keyed by the normalised criteria and their version
+    // stamps, so flipping back to an earlier filter combination is a lookup. Capacity is counted in
+    // result rows. The stats and cache calls are safe from any thread.
+    struct CacheStats {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        int entries = 0;
+    };
+    CacheStats cacheStats() const;
+    void setCacheCapacity(int maxRows);
+    void clearCache();
+
+private:
+    struct CachedResult {
+        QVector<int> rows;   // Rows of allTweets in result order
+        FilterReport report;
+    };
+    static QByteArray cacheKey(const FilterCriteria& criteria);
+    void sortResults(QVector<const TweetData*>& results, const QVector<TweetData>& allTweets,
+                     const FacetIndex& facets, const SearchKeyStore& searchKeys,
+                     const QVector<QByteArray>& utf8Terms, const FilterCriteria& criteria);
+    const QHash<SymbolId, int>& authorRanks(const FacetIndex& facets, quint64 repositoryVersion);
+    void rememberResult(const FilterCriteria& criteria, const QStringList& searchTerms, bool queryMode,
+                        const TweetBitmap& exactRows);
+
+    struct PreviousResult {
+        bool valid = false;
+        FilterCriteria criteria;
+        QStringList searchTerms; // Case-folded plain-text terms; empty in query mode
+        bool queryMode = false;
+        TweetBitmap rows;        // Exact matches, before any fuzzy fallback
+    };
+    // True when every row matching next also matched previous
+    static bool narrows(const PreviousResult& previous, const FilterCriteria& next,
+                        const QStringList& nextTerms, bool nextQueryMode);
+
+    QVector<const TweetData*> fuzzyMatches(
+        const QVector<TweetData>& allTweets,
+        const FacetIndex& facets,
+        const TweetBitmap& candidates,
+        const QString& foldedPattern,
+        int maxResults,
+        int parallelMinRows,
+        const std::function<bool(int, const TweetData&)>& rowFilter,
+        const std::function<bool()>& isCancelled
     ) const;
+
+    PreviousResult m_previous;
+    QHash<SymbolId, int> m_authorRanks;  // Collation order of author names, see authorRanks()
+    quint64 m_authorRanksVersion = 0;
+    bool m_authorRanksValid = false;
+
+    mutable QMutex m_cacheMutex; // Guards everything below
+    QCache<QByteArray, CachedResult> m_resultCache;
+    quint64 m_cacheRepositoryVersion = 0; // Entries for older versions can never hit again
+    quint64 m_cacheHits = 0;
+    quint64 m_cacheMisses = 0;
 };
 
 #endif // TWEETFILTERENGINE_H
\ No newline at end of file
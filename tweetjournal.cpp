@@ -0,0 +1,268 @@
+#include "tweetjournal.h"
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QDebug>
+#ifdef Q_OS_UNIX
+#include <unistd.h> // For fsync
+#endif
+
+namespace {
+
+// QFile::flush() only hands the bytes to the OS; a record is durable once this returns true
+bool syncToDisk(QFile& file)
+{
+    if (!file.flush()) return false;
+#ifdef Q_OS_UNIX
+    return ::fsync(file.handle()) == 0;
+#else
+    return true;
+#endif
+}
+
+int countRecords(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return 0;
+    int lines = 0;
+    while (!file.atEnd()) {
+        if (!file.readLine().trimmed().isEmpty()) ++lines;
+    }
+    return lines;
+}
+
+QStringList stringArray(const QJsonValue& value)
+{
+    QStringList out;
+    const QJsonArray array = value.toArray();
+    for (const QJsonValue& item : array) {
+        if (item.isString()) out.append(item.toString()); // Non-string tags are ignored, as on load
+    }
+    return out;
+}
+
+} // namespace
+
+TweetJournal::TweetJournal()
+    : m_pendingEntries(0)
+{
+}
+
+QString TweetJournal::journalPathFor(const QString& basePath)
+{
+    QFileInfo info(basePath);
+    return info.path() + "/" + info.completeBaseName() + ".journal";
+}
+
+QString TweetJournal::compactingPathFor(const QString& basePath)
+{
+    return journalPathFor(basePath) + ".compacting";
+}
+
+QJsonObject TweetJournal::encodeTweet(const TweetData& tweet)
+{
+    QJsonObject tweetObj;
+    tweetObj["original"] = tweet.originalCode;
+    tweetObj["author"] = tweet.author;
+    tweetObj["source_url"] = tweet.sourceUrl;
+    tweetObj["description"] = tweet.description;
+    tweetObj["publication_date"] = tweet.publicationDate;
+
+    QJsonObject classificationObj;
+    if (!tweet.sonicTags.isEmpty()) {
+        classificationObj["sonic_characteristics"] = QJsonArray::fromStringList(tweet.sonicTags);
+    }
+    if (!tweet.techniqueTags.isEmpty()) {
+        classificationObj["synthesis_techniques"] = QJsonArray::fromStringList(tweet.techniqueTags);
+    }
+    if (!classificationObj.isEmpty()) {
+        tweetObj["classification"] = classificationObj;
+    }
+
+    if (!tweet.genericTags.isEmpty()) {
+        tweetObj["tags"] = QJsonArray::fromStringList(tweet.genericTags);
+    }
+    return tweetObj;
+}
+
+bool TweetJournal::decodeTweet(const QString& id, const QJsonObject& tweetObj, TweetData& out)
+{
+    // Same defaults as TweetJsonStreamReader so a replayed tweet equals a loaded one
+    const QJsonValue original = tweetObj.value("original");
+    if (id.isEmpty() || !original.isString()) return false;
+
+    TweetData td;
+    td.id = id;
+    td.originalCode = original.toString();
+    td.author = tweetObj.value("author").toString("Unknown");
+    td.sourceUrl = tweetObj.value("source_url").toString();
+    td.description = tweetObj.value("description").toString("-");
+    td.publicationDate = tweetObj.value("publication_date").toString("unknown");
+    const QJsonObject classificationObj = tweetObj.value("classification").toObject();
+    td.sonicTags = stringArray(classificationObj.value("sonic_characteristics"));
+    td.techniqueTags = stringArray(classificationObj.value("synthesis_techniques"));
+    td.genericTags = stringArray(tweetObj.value("tags"));
+    out = std::move(td);
+    return true;
+}
+
+QByteArray TweetJournal::encodeCorpus(const QVector<TweetData>& tweets)
+{
+    QJsonObject rootObj;
+    for (const auto& tweet : tweets) {
+        if (tweet.isDeleted()) continue;
+        rootObj[tweet.id] = encodeTweet(tweet);
+    }
+    return QJsonDocument(rootObj).toJson(QJsonDocument::Indented);
+}
+
+QVector<TweetJournal::Entry> TweetJournal::readEntries(const QString& journalPath)
+{
+    QVector<Entry> entries;
+    QFile file(journalPath);
+    if (!file.exists()) return entries;
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "TweetJournal: Could not open" << journalPath << ":" << file.errorString();
+        return entries;
+    }
+
+    int lineNumber = 0;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty()) continue;
+
+        QJsonParseError parseError;
+        const QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+        const QJsonObject record = doc.object();
+        const QString op = record.value("op").toString();
+        const QString id = record.value("id").toString();
+
+        Entry entry;
+        entry.id = id;
+        bool ok = parseError.error == QJsonParseError::NoError && !id.isEmpty();
+        if (ok && op == QLatin1String("upsert")) {
+            entry.op = Entry::Upsert;
+            ok = decodeTweet(id, record.value("tweet").toObject(), entry.tweet);
+        } else if (ok && op == QLatin1String("delete")) {
+            entry.op = Entry::Delete;
+        } else {
+            ok = false;
+        }
+        if (!ok) { // Usually the last line of a journal cut short by a crash
+            qWarning() << "TweetJournal: Skipping unreadable record at" << journalPath << "line" << lineNumber;
+            continue;
+        }
+        entries.append(std::move(entry));
+    }
+    return entries;
+}
+
+bool TweetJournal::open(const QString& basePath)
+{
+    close();
+    m_basePath = basePath;
+    m_file.setFileName(journalPathFor(basePath));
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "TweetJournal: Could not open" << m_file.fileName() << "for appending:" << m_file.errorString();
+        m_basePath.clear();
+        return false;
+    }
+    m_pendingEntries = countRecords(compactingPathFor(basePath)) + countRecords(m_file.fileName());
+    return true;
+}
+
+void TweetJournal::close()
+{
+    if (m_file.isOpen()) m_file.close();
+    m_basePath.clear();
+    m_pendingEntries = 0;
+}
+
+bool TweetJournal::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+QString TweetJournal::basePath() const
+{
+    return m_basePath;
+}
+
+int TweetJournal::pendingEntryCount() const
+{
+    return m_pendingEntries;
+}
+
+bool TweetJournal::appendUpsert(const TweetData& tweet)
+{
+    QJsonObject record;
+    record["op"] = "upsert";
+    record["id"] = tweet.id;
+    record["tweet"] = encodeTweet(tweet);
+    return appendRecord(record);
+}
+
+bool TweetJournal::appendDelete(const QString& id)
+{
+    QJsonObject record;
+    record["op"] = "delete";
+    record["id"] = id;
+    return appendRecord(record);
+}
+
+bool TweetJournal::appendRecord(const QJsonObject& record)
+{
+    if (!m_file.isOpen()) return false;
+    // Compact JSON escapes embedded newlines, so one record is always one line
+    QByteArray line = QJsonDocument(record).toJson(QJsonDocument::Compact);
+    line.append('\n');
+    if (m_file.write(line) != line.size() || !syncToDisk(m_file)) {
+        qWarning() << "TweetJournal: Failed to append to" << m_file.fileName() << ":" << m_file.errorString();
+        return false;
+    }
+    ++m_pendingEntries;
+    return true;
+}
+
+bool TweetJournal::flush()
+{
+    return m_file.isOpen() && syncToDisk(m_file);
+}
+
+bool TweetJournal::rotateForCompaction()
+{
+    if (!m_file.isOpen()) return false;
+    const QString journalPath = m_file.fileName();
+    const QString compactingPath = compactingPathFor(m_basePath);
+    m_file.close();
+
+    bool rotated = true;
+    if (!QFile::exists(compactingPath)) {
+        rotated = QFile::rename(journalPath, compactingPath);
+    } else {
+        // An earlier compaction never finished; its records must stay ahead of ours
+        QFile source(journalPath);
+        QFile target(compactingPath);
+        rotated = source.open(QIODevice::ReadOnly) && target.open(QIODevice::WriteOnly | QIODevice::Append);
+        if (rotated) {
+            const QByteArray pending = source.readAll();
+            rotated = target.write(pending) == pending.size() && syncToDisk(target);
+        }
+        source.close();
+        target.close();
+        if (rotated) QFile::remove(journalPath);
+    }
+    if (!rotated) {
+        qWarning() << "TweetJournal: Could not rotate" << journalPath << "for compaction.";
+    }
+
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "TweetJournal: Could not reopen" << journalPath << ":" << m_file.errorString();
+        m_basePath.clear();
+        return false;
+    }
+    if (rotated) m_pendingEntries = 0;
+    return rotated;
+}
@@ -0,0 +1,58 @@
+#ifndef TWEETJOURNAL_H
+#define TWEETJOURNAL_H
+
+#include "tweetdata.h"
+#include <QFile>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+
+// Append-only change log kept next to a user tweet file (SCTweets_user.json ->
+// SCTweets_user.journal). Every add/update/delete appends and fsyncs one compact
+// JSON line, so a save only has to sync the journal: O(changes). Compaction rotates the journal to a ".compacting"
+// file, rewrites the base file from memory and then drops the rotated file; a
+// load replays the base, then ".compacting", then the live journal. Replay is a
+// sequence of idempotent upserts/deletes, so a crash at any point only means
+// some records are applied twice.
+class TweetJournal
+{
+public:
+    struct Entry {
+        enum Op { Upsert, Delete };
+        Op op = Upsert;
+        QString id;
+        TweetData tweet; // Upsert only
+    };
+
+    TweetJournal();
+
+    static QString journalPathFor(const QString& basePath);
+    static QString compactingPathFor(const QString& basePath);
+    static QVector<Entry> readEntries(const QString& journalPath); // Skips torn or malformed lines
+
+    // Shared with the full-file writer so both produce the same tweet objects
+    static QJsonObject encodeTweet(const TweetData& tweet);
+    static bool decodeTweet(const QString& id, const QJsonObject& tweetObj, TweetData& out);
+    static QByteArray encodeCorpus(const QVector<TweetData>& tweets); // Skips deleted rows
+
+    bool open(const QString& basePath); // Appends to whatever journal is already there
+    void close();
+    bool isOpen() const;
+    QString basePath() const;
+    int pendingEntryCount() const; // Records not yet folded into the base file
+
+    bool appendUpsert(const TweetData& tweet);
+    bool appendDelete(const QString& id);
+    bool flush(); // fsync; every append already does this, so it only re-checks the file
+
+    bool rotateForCompaction(); // Moves the live journal onto ".compacting" and reopens an empty one
+
+private:
+    bool appendRecord(const QJsonObject& record);
+
+    QFile m_file;
+    QString m_basePath;
+    int m_pendingEntries;
+};
+
+#endif // TWEETJOURNAL_H
@@ -0,0 +1,398 @@
+#include "tweetjsonstreamreader.h"
+#include <QIODevice>
+#include <QDebug>
+
+namespace {
+const int kMaxSkipDepth = 512; // Guards skipValue() recursion on hostile input
+}
+
+TweetJsonStreamReader::TweetJsonStreamReader(QIODevice* device, qint64 chunkSize)
+    : m_device(device),
+      m_chunkSize(chunkSize > 0 ? chunkSize : 64 * 1024),
+      m_totalBytes(device ? device->size() : 0),
+      m_consumedBefore(0),
+      m_pos(0),
+      m_firstEntry(true),
+      m_finished(false)
+{
+}
+
+bool TweetJsonStreamReader::begin()
+{
+    if (!m_device || !m_device->isReadable()) {
+        setError("Device is not readable");
+        return false;
+    }
+    // Skip an optional UTF-8 byte order mark
+    char c;
+    if (peekChar(c) && static_cast<unsigned char>(c) == 0xEF) {
+        char bom[3];
+        for (char& b : bom) {
+            if (!takeChar(b)) { setError("Truncated byte order mark"); return false; }
+        }
+        if (static_cast<unsigned char>(bom[1]) != 0xBB || static_cast<unsigned char>(bom[2]) != 0xBF) {
+            setError("Invalid byte order mark");
+            return false;
+        }
+    }
+    skipWhitespace();
+    if (!peekChar(c) || c != '{') {
+        setError("Tweet file root is not a valid JSON object");
+        return false;
+    }
+    return expectChar('{');
+}
+
+bool TweetJsonStreamReader::readNext(TweetData& out)
+{
+    while (true) {
+        if (m_finished || hasError()) return false;
+
+        skipWhitespace();
+        char c;
+        if (!peekChar(c)) {
+            setError("Unexpected end of file inside root object");
+            return false;
+        }
+        if (c == '}') {
+            takeChar(c);
+            m_finished = true;
+            skipWhitespace();
+            if (peekChar(c)) { // A second document or stray bytes: QJsonDocument rejected these too
+                setError(QString("Unexpected content after the root object at byte %1").arg(bytesConsumed()));
+            }
+            return false;
+        }
+        if (!m_firstEntry) {
+            if (!expectChar(',')) return false;
+            skipWhitespace();
+        }
+        m_firstEntry = false;
+
+        QString key;
+        if (!parseString(key)) return false;
+        skipWhitespace();
+        if (!expectChar(':')) return false;
+        skipWhitespace();
+
+        if (!peekChar(c)) {
+            setError("Unexpected end of file after key " + key);
+            return false;
+        }
+        if (c != '{') {
+            qWarning() << "TweetJsonStreamReader: Item with key" << key << "is not an object. Skipping.";
+            if (!skipValue()) return false;
+            continue;
+        }
+
+        TweetData td;
+        td.id = key;
+        td.author = "Unknown";
+        td.description = "-";
+        td.publicationDate = "unknown";
+        bool hasOriginal = false;
+        if (!parseTweetObject(td, hasOriginal)) return false;
+        if (!hasOriginal) {
+            qWarning() << "TweetJsonStreamReader: Item with key" << key << "is missing 'original' code. Skipping.";
+            continue;
+        }
+        out = std::move(td);
+        return true;
+    }
+}
+
+bool TweetJsonStreamReader::fillBuffer()
+{
+    if (m_pos > 0) { // Drop what has already been consumed so the buffer never grows past one chunk + one token
+        m_consumedBefore += m_pos;
+        m_buffer.remove(0, m_pos);
+        m_pos = 0;
+    }
+    QByteArray chunk = m_device->read(m_chunkSize);
+    if (chunk.isEmpty()) return false;
+    m_buffer.append(chunk);
+    return true;
+}
+
+bool TweetJsonStreamReader::peekChar(char& c)
+{
+    if (m_pos >= m_buffer.size() && !fillBuffer()) return false;
+    c = m_buffer.at(m_pos);
+    return true;
+}
+
+bool TweetJsonStreamReader::takeChar(char& c)
+{
+    if (!peekChar(c)) return false;
+    ++m_pos;
+    return true;
+}
+
+bool TweetJsonStreamReader::expectChar(char expected)
+{
+    char c;
+    if (!takeChar(c)) {
+        setError(QString("Expected '%1' but reached end of file").arg(QChar(expected)));
+        return false;
+    }
+    if (c != expected) {
+        setError(QString("Expected '%1' at byte %2").arg(QChar(expected)).arg(bytesConsumed() - 1));
+        return false;
+    }
+    return true;
+}
+
+void TweetJsonStreamReader::skipWhitespace()
+{
+    char c;
+    while (peekChar(c) && (c == ' ' || c == '\n' || c == '\r' || c == '\t')) {
+        ++m_pos;
+    }
+}
+
+bool TweetJsonStreamReader::parseString(QString& out)
+{
+    if (!expectChar('"')) return false;
+    out.clear();
+    QByteArray pending; // Raw UTF-8 run, decoded in one go when the string (or a \u escape) ends
+
+    while (true) {
+        if (m_pos >= m_buffer.size() && !fillBuffer()) {
+            setError("Unterminated string");
+            return false;
+        }
+        const char* data = m_buffer.constData();
+        const qint64 end = m_buffer.size();
+        qint64 i = m_pos;
+        while (i < end && data[i] != '"' && data[i] != '\\') ++i;
+        pending.append(data + m_pos, i - m_pos);
+        m_pos = i;
+        if (i == end) continue; // Need the next chunk
+
+        const char c = data[i];
+        ++m_pos;
+        if (c == '"') break;
+
+        char esc;
+        if (!takeChar(esc)) {
+            setError("Unterminated escape sequence");
+            return false;
+        }
+        switch (esc) {
+        case '"':  pending.append('"'); break;
+        case '\\': pending.append('\\'); break;
+        case '/':  pending.append('/'); break;
+        case 'b':  pending.append('\b'); break;
+        case 'f':  pending.append('\f'); break;
+        case 'n':  pending.append('\n'); break;
+        case 'r':  pending.append('\r'); break;
+        case 't':  pending.append('\t'); break;
+        case 'u': {
+            ushort code = 0;
+            for (int k = 0; k < 4; ++k) {
+                char h;
+                if (!takeChar(h)) { setError("Truncated \\u escape"); return false; }
+                code <<= 4;
+                if (h >= '0' && h <= '9') code |= ushort(h - '0');
+                else if (h >= 'a' && h <= 'f') code |= ushort(h - 'a' + 10);
+                else if (h >= 'A' && h <= 'F') code |= ushort(h - 'A' + 10);
+                else { setError("Invalid \\u escape"); return false; }
+            }
+            // Surrogate pairs arrive as two escapes and land as two UTF-16 units, which is what QString wants
+            out.append(QString::fromUtf8(pending));
+            pending.clear();
+            out.append(QChar(code));
+            break;
+        }
+        default:
+            setError(QString("Invalid escape '\\%1' at byte %2").arg(QChar(esc)).arg(bytesConsumed() - 1));
+            return false;
+        }
+    }
+    out.append(QString::fromUtf8(pending));
+    return true;
+}
+
+bool TweetJsonStreamReader::parseStringArray(QStringList& out)
+{
+    out.clear(); // Last occurrence of a duplicated key wins, as with QJsonObject
+    if (!expectChar('[')) return false;
+    skipWhitespace();
+    char c;
+    if (peekChar(c) && c == ']') { ++m_pos; return true; }
+
+    while (true) {
+        skipWhitespace();
+        if (!peekChar(c)) { setError("Unterminated array"); return false; }
+        if (c == '"') {
+            QString value;
+            if (!parseString(value)) return false;
+            out.append(value);
+        } else if (!skipValue()) { // Non-string tags are ignored
+            return false;
+        }
+        skipWhitespace();
+        if (!takeChar(c)) { setError("Unterminated array"); return false; }
+        if (c == ']') return true;
+        if (c != ',') { setError(QString("Expected ',' or ']' at byte %1").arg(bytesConsumed() - 1)); return false; }
+    }
+}
+
+bool TweetJsonStreamReader::parseClassification(TweetData& td)
+{
+    if (!expectChar('{')) return false;
+    skipWhitespace();
+    char c;
+    if (peekChar(c) && c == '}') { ++m_pos; return true; }
+
+    while (true) {
+        skipWhitespace();
+        QString key;
+        if (!parseString(key)) return false;
+        skipWhitespace();
+        if (!expectChar(':')) return false;
+        skipWhitespace();
+        if (!peekChar(c)) { setError("Unterminated classification object"); return false; }
+
+        bool ok;
+        if (key == QLatin1String("sonic_characteristics") && c == '[') ok = parseStringArray(td.sonicTags);
+        else if (key == QLatin1String("synthesis_techniques") && c == '[') ok = parseStringArray(td.techniqueTags);
+        else ok = skipValue();
+        if (!ok) return false;
+
+        skipWhitespace();
+        if (!takeChar(c)) { setError("Unterminated classification object"); return false; }
+        if (c == '}') return true;
+        if (c != ',') { setError(QString("Expected ',' or '}' at byte %1").arg(bytesConsumed() - 1)); return false; }
+    }
+}
+
+bool TweetJsonStreamReader::parseTweetObject(TweetData& td, bool& hasOriginal)
+{
+    if (!expectChar('{')) return false;
+    skipWhitespace();
+    char c;
+    if (peekChar(c) && c == '}') { ++m_pos; return true; }
+
+    while (true) {
+        skipWhitespace();
+        QString key;
+        if (!parseString(key)) return false;
+        skipWhitespace();
+        if (!expectChar(':')) return false;
+        skipWhitespace();
+        if (!peekChar(c)) { setError("Unterminated tweet object " + td.id); return false; }
+
+        // Non-string values for string fields keep their defaults, matching QJsonValue::toString(default)
+        QString* stringField = nullptr;
+        if (key == QLatin1String("original")) stringField = &td.originalCode;
+        else if (key == QLatin1String("author")) stringField = &td.author;
+        else if (key == QLatin1String("source_url")) stringField = &td.sourceUrl;
+        else if (key == QLatin1String("description")) stringField = &td.description;
+        else if (key == QLatin1String("publication_date")) stringField = &td.publicationDate;
+
+        bool ok;
+        if (stringField && c == '"') {
+            ok = parseString(*stringField);
+            if (stringField == &td.originalCode) hasOriginal = true;
+        } else if (key == QLatin1String("classification") && c == '{') {
+            ok = parseClassification(td);
+        } else if (key == QLatin1String("tags") && c == '[') {
+            ok = parseStringArray(td.genericTags);
+        } else {
+            ok = skipValue();
+        }
+        if (!ok) return false;
+
+        skipWhitespace();
+        if (!takeChar(c)) { setError("Unterminated tweet object " + td.id); return false; }
+        if (c == '}') return true;
+        if (c != ',') { setError(QString("Expected ',' or '}' at byte %1").arg(bytesConsumed() - 1)); return false; }
+    }
+}
+
+bool TweetJsonStreamReader::skipValue(int depth)
+{
+    if (depth > kMaxSkipDepth) {
+        setError("JSON nesting too deep");
+        return false;
+    }
+    skipWhitespace();
+    char c;
+    if (!peekChar(c)) { setError("Unexpected end of file while skipping value"); return false; }
+
+    if (c == '"') {
+        QString ignored;
+        return parseString(ignored);
+    }
+    if (c == '{' || c == '[') {
+        const char close = (c == '{') ? '}' : ']';
+        ++m_pos;
+        skipWhitespace();
+        if (peekChar(c) && c == close) { ++m_pos; return true; }
+        while (true) {
+            skipWhitespace();
+            if (close == '}') {
+                QString ignoredKey;
+                if (!parseString(ignoredKey)) return false;
+                skipWhitespace();
+                if (!expectChar(':')) return false;
+            }
+            if (!skipValue(depth + 1)) return false;
+            skipWhitespace();
+            if (!takeChar(c)) { setError("Unterminated container"); return false; }
+            if (c == close) return true;
+            if (c != ',') { setError(QString("Unexpected '%1' at byte %2").arg(QChar(c)).arg(bytesConsumed() - 1)); return false; }
+        }
+    }
+    return skipLiteral();
+}
+
+bool TweetJsonStreamReader::skipLiteral()
+{
+    const qint64 start = bytesConsumed();
+    char c;
+    if (!peekChar(c)) { setError("Unexpected end of file while skipping value"); return false; }
+
+    if (c == 't' || c == 'f' || c == 'n') {
+        const char* word = (c == 't') ? "true" : (c == 'f') ? "false" : "null";
+        for (const char* w = word; *w; ++w) {
+            if (!takeChar(c) || c != *w) {
+                setError(QString("Invalid literal at byte %1").arg(start));
+                return false;
+            }
+        }
+        return true; // Whatever follows is checked by the caller, like after any other value
+    }
+
+    // Number: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    auto skipDigits = [this, &c]() {
+        qint64 count = 0;
+        while (peekChar(c) && c >= '0' && c <= '9') { ++m_pos; ++count; }
+        return count;
+    };
+    if (c == '-') ++m_pos;
+    if (!peekChar(c) || c < '0' || c > '9') {
+        setError(QString("Unexpected character at byte %1").arg(start));
+        return false;
+    }
+    if (c == '0') ++m_pos; // No leading zeros; a following digit fails at the caller's separator check
+    else skipDigits();
+    if (peekChar(c) && c == '.') {
+        ++m_pos;
+        if (skipDigits() == 0) { setError(QString("Invalid number at byte %1").arg(start)); return false; }
+    }
+    if (peekChar(c) && (c == 'e' || c == 'E')) {
+        ++m_pos;
+        if (peekChar(c) && (c == '+' || c == '-')) ++m_pos;
+        if (skipDigits() == 0) { setError(QString("Invalid number at byte %1").arg(start)); return false; }
+    }
+    return true;
+}
+
+void TweetJsonStreamReader::setError(const QString& message)
+{
+    if (m_errorString.isEmpty()) {
+        m_errorString = message;
+    }
+}
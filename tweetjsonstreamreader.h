@@ -0,0 +1,62 @@
+#ifndef TWEETJSONSTREAMREADER_H
+#define TWEETJSONSTREAMREADER_H
+
+#include "tweetdata.h"
+#include <QByteArray>
+#include <QString>
+
+QT_BEGIN_NAMESPACE
+class QIODevice;
+QT_END_NAMESPACE
+
+// Pull parser for the SCTweets JSON layout ({ "<id>": { ...tweet... }, ... }).
+// Reads the device in fixed-size chunks and decodes one tweet object at a time
+// straight into TweetData, so memory use is bounded by the largest record
+// instead of the whole file. No QJsonDocument DOM is ever built.
+class TweetJsonStreamReader
+{
+public:
+    explicit TweetJsonStreamReader(QIODevice* device, qint64 chunkSize = 64 * 1024);
+
+    // Consumes the opening '{' of the root object. Must succeed before readNext().
+    bool begin();
+
+    // Decodes the next tweet into 'out'. Returns false at the end of the root
+    // object or on error; check hasError() to tell the two apart. Anything but
+    // whitespace after the root object is an error.
+    // Entries that are not objects or lack 'original' code are skipped with a warning.
+    bool readNext(TweetData& out);
+
+    bool hasError() const { return !m_errorString.isEmpty(); }
+    QString errorString() const { return m_errorString; }
+    qint64 bytesConsumed() const { return m_consumedBefore + m_pos; }
+    qint64 totalBytes() const { return m_totalBytes; }
+
+private:
+    bool fillBuffer();
+    bool peekChar(char& c);
+    bool takeChar(char& c);
+    bool expectChar(char expected);
+    void skipWhitespace();
+
+    bool parseString(QString& out);
+    bool parseStringArray(QStringList& out);
+    bool parseClassification(TweetData& td);
+    bool parseTweetObject(TweetData& td, bool& hasOriginal);
+    bool skipValue(int depth = 0);
+    bool skipLiteral(); // true, false, null or a JSON number; nothing else
+
+    void setError(const QString& message);
+
+    QIODevice* m_device;
+    qint64 m_chunkSize;
+    qint64 m_totalBytes;
+    qint64 m_consumedBefore; // Bytes dropped from the front of m_buffer so far
+    QByteArray m_buffer;
+    qint64 m_pos;            // Read position inside m_buffer
+    bool m_firstEntry;
+    bool m_finished;
+    QString m_errorString;
+};
+
+#endif // TWEETJSONSTREAMREADER_H
@@ -0,0 +1,478 @@
+#include "tweetquery.h"
+#include "facetindex.h"
+#include "trigramindex.h"
+#include "searchkeystore.h"
+#include "symboltable.h"
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QStringView>
+#include <algorithm> // For std::stable_sort
+
+namespace {
+
+bool fieldFromName(const QString& name, TweetQuery::Field& field)
+{
+    const QString lower = name.toLower();
+    if (lower == QLatin1String("ugen") || lower == QLatin1String("ugens")) field = TweetQuery::Field::Ugen;
+    else if (lower == QLatin1String("sonic")) field = TweetQuery::Field::Sonic;
+    else if (lower == QLatin1String("tech") || lower == QLatin1String("technique")) field = TweetQuery::Field::Technique;
+    else if (lower == QLatin1String("author")) field = TweetQuery::Field::Author;
+    else if (lower == QLatin1String("tag") || lower == QLatin1String("tags")) field = TweetQuery::Field::Tag;
+    else if (lower == QLatin1String("id")) field = TweetQuery::Field::Id;
+    else return false;
+    return true;
+}
+
+QString fieldName(TweetQuery::Field field)
+{
+    switch (field) {
+    case TweetQuery::Field::Ugen: return "ugen";
+    case TweetQuery::Field::Sonic: return "sonic";
+    case TweetQuery::Field::Technique: return "tech";
+    case TweetQuery::Field::Author: return "author";
+    case TweetQuery::Field::Tag: return "tag";
+    case TweetQuery::Field::Id: return "id";
+    case TweetQuery::Field::Text: break;
+    }
+    return QString();
+}
+
+bool facetKindFor(TweetQuery::Field field, FacetKind& kind)
+{
+    switch (field) {
+    case TweetQuery::Field::Ugen: kind = FacetKind::Ugen; return true;
+    case TweetQuery::Field::Sonic: kind = FacetKind::SonicTag; return true;
+    case TweetQuery::Field::Technique: kind = FacetKind::TechniqueTag; return true;
+    case TweetQuery::Field::Author: kind = FacetKind::Author; return true;
+    case TweetQuery::Field::Tag: kind = FacetKind::GenericTag; return true;
+    case TweetQuery::Field::Id:
+    case TweetQuery::Field::Text: break;
+    }
+    return false;
+}
+
+// Walks the AST against the repository indexes; every result is a subset of the 'within' rows passed in
+class QueryExecutor
+{
+public:
+    QueryExecutor(const FacetIndex& facets, const TrigramIndex& trigrams,
+                  const SearchKeyStore& searchKeys, QStringList* explain)
+        : m_facets(facets), m_trigrams(trigrams), m_searchKeys(searchKeys), m_explain(explain),
+          m_liveCount(facets.liveRows().count())
+    {
+    }
+
+    int estimate(const TweetQuery::NodePtr& node) const
+    {
+        switch (node->kind) {
+        case TweetQuery::Node::Term: {
+            FacetKind kind;
+            if (facetKindFor(node->field, kind)) {
+                return m_facets.count(kind, SymbolTable::instance().lookup(node->value));
+            }
+            const int bound = m_trigrams.estimateCandidates(node->value);
+            return bound < 0 ? m_liveCount : bound;
+        }
+        case TweetQuery::Node::And: {
+            int best = m_liveCount;
+            for (const auto& child : node->children) {
+                if (child->kind != TweetQuery::Node::Not) best = qMin(best, estimate(child));
+            }
+            return best;
+        }
+        case TweetQuery::Node::Or: {
+            qint64 sum = 0;
+            for (const auto& child : node->children) sum += estimate(child);
+            return int(qMin<qint64>(sum, m_liveCount));
+        }
+        case TweetQuery::Node::Not:
+            return qMax(0, m_liveCount - estimate(node->children.first()));
+        }
+        return m_liveCount;
+    }
+
+    TweetBitmap run(const TweetQuery::NodePtr& node, const TweetBitmap& within, int depth)
+    {
+        const int line = beginStep();
+        QString description;
+        TweetBitmap result;
+
+        switch (node->kind) {
+        case TweetQuery::Node::Term:
+            result = runTerm(node, within, description);
+            break;
+
+        case TweetQuery::Node::And: {
+            description = "AND";
+            QVector<TweetQuery::NodePtr> positives;
+            QVector<TweetQuery::NodePtr> negated; // Inner nodes of NOT children
+            for (const auto& child : node->children) {
+                if (child->kind == TweetQuery::Node::Not) negated.append(child->children.first());
+                else positives.append(child);
+            }
+            // Most selective first: every later child only looks at the rows still standing
+            std::stable_sort(positives.begin(), positives.end(),
+                             [this](const TweetQuery::NodePtr& a, const TweetQuery::NodePtr& b) {
+                                 return estimate(a) < estimate(b);
+                             });
+            result = within;
+            for (const auto& child : positives) {
+                if (result.isEmpty()) break;
+                result = run(child, result, depth + 1);
+            }
+            // NOT as a complement of the running set rather than of the whole corpus
+            for (const auto& inner : negated) {
+                if (result.isEmpty()) break;
+                const int notLine = beginStep();
+                const int before = result.count();
+                result.andNot(run(inner, result, depth + 2));
+                endStep(notLine, depth + 1, QString("AND NOT (complement, removed %1)").arg(before - result.count()),
+                        -1, result.count());
+            }
+            break;
+        }
+
+        case TweetQuery::Node::Or: {
+            description = "OR";
+            TweetBitmap remaining = within;
+            for (const auto& child : node->children) {
+                if (remaining.isEmpty()) break;
+                const TweetBitmap matched = run(child, remaining, depth + 1);
+                result |= matched;
+                remaining.andNot(matched); // Rows already in need not be checked again
+            }
+            break;
+        }
+
+        case TweetQuery::Node::Not:
+            description = "NOT (complement)";
+            result = within;
+            result.andNot(run(node->children.first(), within, depth + 1));
+            break;
+        }
+
+        endStep(line, depth, description, estimate(node), result.count());
+        return result;
+    }
+
+private:
+    TweetBitmap runTerm(const TweetQuery::NodePtr& node, const TweetBitmap& within, QString& description)
+    {
+        FacetKind kind;
+        if (facetKindFor(node->field, kind)) {
+            description = QString("%1:%2 [postings]").arg(fieldName(node->field), node->value);
+            TweetBitmap rows = m_facets.postings(kind, SymbolTable::instance().lookup(node->value));
+            rows &= within;
+            return rows;
+        }
+
+        const bool idOnly = node->field == TweetQuery::Field::Id;
+        const QByteArray utf8Value = node->value.toUtf8();
+        auto verify = [&](int row) {
+            // The key starts with the case-folded id, see TweetRepository::deriveSearchFields
+            const QByteArrayView key = m_searchKeys.key(row);
+            if (!idOnly) return key.contains(utf8Value);
+            const qsizetype idEnd = key.indexOf('\n');
+            return (idEnd < 0 ? key : key.first(idEnd)).contains(utf8Value);
+        };
+
+        TweetBitmap rows;
+        QVector<int> candidates;
+        const QString label = idOnly ? QString("id:\"%1\"").arg(node->value) : QString("\"%1\"").arg(node->value);
+        if (m_trigrams.candidates(node->value, candidates)) {
+            description = label + " [trigrams + substring check]";
+            for (int row : candidates) {
+                if (within.test(row) && verify(row)) rows.set(row);
+            }
+        } else {
+            description = label + " [substring scan]"; // Shorter than a trigram
+            within.forEachRow([&](int row) {
+                if (verify(row)) rows.set(row);
+            });
+        }
+        return rows;
+    }
+
+    int beginStep()
+    {
+        if (!m_explain) return -1;
+        m_explain->append(QString()); // Filled in by endStep once the row count is known
+        return int(m_explain->size()) - 1;
+    }
+
+    void endStep(int line, int depth, const QString& description, int estimated, int actual)
+    {
+        if (!m_explain || line < 0) return;
+        QString text = QString(depth * 2, QLatin1Char(' ')) + description;
+        if (estimated >= 0) text += QString("  est. %1").arg(estimated);
+        text += QString("  -> %1 rows").arg(actual);
+        (*m_explain)[line] = text;
+    }
+
+    const FacetIndex& m_facets;
+    const TrigramIndex& m_trigrams;
+    const SearchKeyStore& m_searchKeys;
+    QStringList* m_explain;
+    int m_liveCount;
+};
+
+} // namespace
+
+bool TweetQuery::looksLikeQuery(const QString& text)
+{
+    static const QRegularExpression separators(R"([\s()]+)");
+    const QStringList parts = text.split(separators, Qt::SkipEmptyParts);
+    for (const QString& part : parts) {
+        if (part == QLatin1String("AND") || part == QLatin1String("OR") ||
+            part == QLatin1String("NOT") || part == QLatin1String("EXPLAIN")) {
+            return true;
+        }
+        const qsizetype colon = part.indexOf(QLatin1Char(':'));
+        Field field;
+        if (colon > 0 && fieldFromName(part.left(colon), field)) return true;
+    }
+    return false;
+}
+
+bool TweetQuery::parse(const QString& text)
+{
+    m_tokens.clear();
+    m_pos = 0;
+    m_root.reset();
+    m_explain = false;
+    m_error.clear();
+
+    if (!tokenize(text)) return false;
+    if (m_tokens.isEmpty()) {
+        setError("Empty query");
+        return false;
+    }
+
+    m_root = parseOr();
+    if (!m_error.isEmpty()) return false;
+    if (peek().type != Token::End) {
+        setError(peek().type == Token::RightParen ? "Unbalanced ')'" : "Unexpected input after the query");
+        return false;
+    }
+    return true;
+}
+
+QString TweetQuery::errorString() const
+{
+    return m_error;
+}
+
+bool TweetQuery::isExplain() const
+{
+    return m_explain;
+}
+
+QString TweetQuery::toString() const
+{
+    return m_root ? nodeToString(m_root) : QString();
+}
+
+TweetBitmap TweetQuery::evaluate(const FacetIndex& facets,
+                                 const TrigramIndex& trigrams,
+                                 const SearchKeyStore& searchKeys,
+                                 const TweetBitmap& within,
+                                 QStringList* explain) const
+{
+    if (!m_root) return TweetBitmap();
+    QElapsedTimer timer;
+    timer.start();
+    if (explain) explain->append("EXPLAIN " + toString());
+
+    QueryExecutor executor(facets, trigrams, searchKeys, explain);
+    const TweetBitmap rows = executor.run(m_root, within, 1);
+
+    if (explain) {
+        explain->append(QString("Result: %1 rows in %2 ms").arg(rows.count()).arg(timer.nsecsElapsed() / 1e6, 0, 'f', 3));
+    }
+    return rows;
+}
+
+bool TweetQuery::tokenize(const QString& text)
+{
+    auto readQuoted = [&](int& i, QString& out) {
+        const int close = int(text.indexOf(QLatin1Char('"'), i + 1));
+        if (close < 0) {
+            setError(QString("Unterminated quote at column %1").arg(i + 1));
+            return false;
+        }
+        out = text.mid(i + 1, close - i - 1);
+        i = close + 1;
+        return true;
+    };
+
+    int i = 0;
+    const int n = int(text.size());
+    while (i < n) {
+        const QChar c = text.at(i);
+        if (c.isSpace()) { ++i; continue; }
+
+        Token token;
+        if (c == QLatin1Char('(')) { token.type = Token::LeftParen; ++i; }
+        else if (c == QLatin1Char(')')) { token.type = Token::RightParen; ++i; }
+        else if (c == QLatin1Char('"')) {
+            token.type = Token::Word;
+            if (!readQuoted(i, token.value)) return false;
+        } else {
+            const int start = i;
+            while (i < n && !text.at(i).isSpace() && text.at(i) != QLatin1Char('(') &&
+                   text.at(i) != QLatin1Char(')') && text.at(i) != QLatin1Char('"')) {
+                ++i;
+            }
+            QString word = text.mid(start, i - start);
+            if (word == QLatin1String("EXPLAIN") && m_tokens.isEmpty() && !m_explain) {
+                m_explain = true; // Only as the very first word
+                continue;
+            }
+            if (word == QLatin1String("AND")) token.type = Token::And;
+            else if (word == QLatin1String("OR")) token.type = Token::Or;
+            else if (word == QLatin1String("NOT")) token.type = Token::Not;
+            else {
+                token.type = Token::Word;
+                const qsizetype colon = word.indexOf(QLatin1Char(':'));
+                Field field;
+                if (colon > 0 && fieldFromName(word.left(colon), field)) {
+                    token.field = field;
+                    word = word.mid(colon + 1);
+                    if (word.isEmpty() && i < n && text.at(i) == QLatin1Char('"')) { // author:"some name"
+                        if (!readQuoted(i, word)) return false;
+                    }
+                    if (word.isEmpty()) {
+                        setError(QString("Missing value after '%1:'").arg(fieldName(field)));
+                        return false;
+                    }
+                }
+                token.value = word;
+            }
+        }
+        if (token.type == Token::Word) token.value = token.value.toCaseFolded();
+        m_tokens.append(token);
+    }
+    return true;
+}
+
+TweetQuery::NodePtr TweetQuery::parseOr()
+{
+    NodePtr left = parseAnd();
+    while (m_error.isEmpty() && peek().type == Token::Or) {
+        take();
+        NodePtr right = parseAnd();
+        if (!m_error.isEmpty()) return NodePtr();
+        if (left->kind != Node::Or) {
+            NodePtr group(new Node);
+            group->kind = Node::Or;
+            group->children.append(left);
+            left = group;
+        }
+        left->children.append(right);
+    }
+    return left;
+}
+
+TweetQuery::NodePtr TweetQuery::parseAnd()
+{
+    NodePtr left = parseUnary();
+    while (m_error.isEmpty()) {
+        const Token::Type next = peek().type;
+        if (next == Token::And) {
+            take();
+        } else if (next != Token::Word && next != Token::LeftParen && next != Token::Not) {
+            break; // Adjacent terms are an implicit AND; anything else ends this group
+        }
+        NodePtr right = parseUnary();
+        if (!m_error.isEmpty()) return NodePtr();
+        if (left->kind != Node::And) {
+            NodePtr group(new Node);
+            group->kind = Node::And;
+            group->children.append(left);
+            left = group;
+        }
+        left->children.append(right);
+    }
+    return left;
+}
+
+TweetQuery::NodePtr TweetQuery::parseUnary()
+{
+    if (peek().type == Token::Not) {
+        take();
+        NodePtr inner = parseUnary();
+        if (!m_error.isEmpty()) return NodePtr();
+        if (inner->kind == Node::Not) return inner->children.first(); // NOT NOT x == x
+        NodePtr node(new Node);
+        node->kind = Node::Not;
+        node->children.append(inner);
+        return node;
+    }
+    return parsePrimary();
+}
+
+TweetQuery::NodePtr TweetQuery::parsePrimary()
+{
+    const Token token = take();
+    switch (token.type) {
+    case Token::LeftParen: {
+        NodePtr inner = parseOr();
+        if (!m_error.isEmpty()) return NodePtr();
+        if (take().type != Token::RightParen) {
+            setError("Missing ')'");
+            return NodePtr();
+        }
+        return inner;
+    }
+    case Token::Word: {
+        NodePtr node(new Node);
+        node->kind = Node::Term;
+        node->field = token.field;
+        node->value = token.value;
+        return node;
+    }
+    case Token::End:
+        setError("Query ends where a search term was expected");
+        return NodePtr();
+    default:
+        setError("Expected a search term, field:value or '('");
+        return NodePtr();
+    }
+}
+
+const TweetQuery::Token& TweetQuery::peek() const
+{
+    static const Token end;
+    return m_pos < m_tokens.size() ? m_tokens.at(m_pos) : end;
+}
+
+TweetQuery::Token TweetQuery::take()
+{
+    Token token = peek();
+    if (m_pos < m_tokens.size()) ++m_pos;
+    return token;
+}
+
+void TweetQuery::setError(const QString& message)
+{
+    if (m_error.isEmpty()) m_error = message;
+}
+
+QString TweetQuery::nodeToString(const NodePtr& node)
+{
+    switch (node->kind) {
+    case Node::Term: {
+        const QString value = node->value.contains(QLatin1Char(' ')) ? QString("\"%1\"").arg(node->value) : node->value;
+        return node->field == Field::Text ? value : fieldName(node->field) + ":" + value;
+    }
+    case Node::Not:
+        return "NOT " + nodeToString(node->children.first());
+    case Node::And:
+    case Node::Or: {
+        QStringList parts;
+        for (const auto& child : node->children) parts.append(nodeToString(child));
+        return "(" + parts.join(node->kind == Node::And ? " AND " : " OR ") + ")";
+    }
+    }
+    return QString();
+}
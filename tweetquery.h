@@ -0,0 +1,83 @@
+#ifndef TWEETQUERY_H
+#define TWEETQUERY_H
+
+#include "tweetdata.h"
+#include "tweetbitmap.h"
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class FacetIndex;
+class TrigramIndex;
+class SearchKeyStore;
+
+// Boolean search-box queries such as
+//   ugen:LocalIn AND (sonic:drone OR tech:fm) AND NOT author:earslap
+// Fields: ugen:, sonic:, tech:, author:, tag: (exact facet values, case-insensitive),
+// id: (substring of the id); a bare word or "quoted phrase" is a substring of the
+// whole TweetData::searchKey. NOT binds tightest, then AND (also implied between
+// adjacent terms), then OR; keywords must be upper case so "and" stays searchable.
+// A leading EXPLAIN keyword asks for the evaluated plan with per-step row counts.
+//
+// evaluate() runs directly on the repository indexes: facet terms are postings,
+// text terms trigram candidates plus a substring check. Each AND evaluates its
+// children most-selective first, narrowing the rows the next child has to look at,
+// and applies NOT children last as a complement (andNot) of that running set.
+class TweetQuery
+{
+public:
+    enum class Field { Text, Id, Author, Sonic, Technique, Tag, Ugen };
+
+    struct Node {
+        enum Kind { And, Or, Not, Term };
+        Kind kind = Term;
+        Field field = Field::Text;
+        QString value; // Case-folded
+        QVector<QSharedPointer<Node>> children;
+    };
+    using NodePtr = QSharedPointer<Node>;
+
+    // Cheap check so plain searches ("feedback drone") keep their own path and fuzzy fallback
+    static bool looksLikeQuery(const QString& text);
+
+    bool parse(const QString& text); // False on a syntax error, see errorString()
+    QString errorString() const;
+    bool isExplain() const;
+    QString toString() const; // Normalised, fully parenthesised form
+
+    // Repository rows matching the query, restricted to 'within'. With 'explain', one
+    // indented line per evaluated step is appended, with its estimate and actual row count.
+    TweetBitmap evaluate(const FacetIndex& facets,
+                         const TrigramIndex& trigrams,
+                         const SearchKeyStore& searchKeys,
+                         const TweetBitmap& within,
+                         QStringList* explain = nullptr) const;
+
+private:
+    struct Token {
+        enum Type { Word, LeftParen, RightParen, And, Or, Not, End };
+        Type type = End;
+        Field field = Field::Text;
+        QString value;
+    };
+
+    bool tokenize(const QString& text);
+    NodePtr parseOr();
+    NodePtr parseAnd();
+    NodePtr parseUnary();
+    NodePtr parsePrimary();
+    const Token& peek() const;
+    Token take();
+    void setError(const QString& message);
+
+    static QString nodeToString(const NodePtr& node);
+
+    QVector<Token> m_tokens;
+    int m_pos = 0;
+    NodePtr m_root;
+    bool m_explain = false;
+    QString m_error;
+};
+
+#endif // TWEETQUERY_H
@@ -1,22 +1,96 @@
 #include "tweetrepository.h"
+#include "tweetjsonstreamreader.h"
+#include "tweetsnapshot.h"
+#include "symboltable.h"
 #include <QFile>            // For QFile
-#include <QJsonDocument>    // For QJsonDocument
-#include <QJsonObject>      // For QJsonObject
-#include <QJsonArray>       // For QJsonArray
+#include <QSaveFile>
+#include <QDate>
+#include <QDateTime>
+#include <QFileInfo>
 #include <QRegularExpression> 
 #include <QDebug>           // For qInfo, qWarning, qCritical
 #include <QSet>             
 #include <QStandardPaths>   // For QStandardPaths
 #include <QDir>             // For QDir
 #include <QIODevice>        // For QIODevice::WriteOnly etc.
+#include <QHash>
+#include <QCoreApplication> // For sendPostedEvents in waitForPendingLoad
+#include <QThread>          // For QThread::idealThreadCount
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <utility>          // For std::exchange
+#include <algorithm>        // For std::sort
+#ifdef Q_OS_UNIX
+#include <fcntl.h>          // For open
+#include <unistd.h>         // For fsync, close
+#endif
+
+namespace {
+const int kLoadBatchSize = 512; // Tweets per load-pool batch and per tweetsBatchLoaded/loadProgress emission
+const int kMinTombstonesBeforeCompaction = 64; // Compact once tombstones exceed this and half of all rows
+const int kRowHeadroom = 256;                   // Spare row capacity after a load or compaction, for a session's adds
+const int kJournalCompactionThreshold = 256;    // Journal records before the base file is rewritten unprompted
+
+bool syncToDisk(QFileDevice& file)
+{
+    if (!file.flush()) return false;
+#ifdef Q_OS_UNIX
+    return ::fsync(file.handle()) == 0;
+#else
+    return true; // QSaveFile::commit() flushes the OS buffers itself where fsync is unavailable
+#endif
+}
+
+void syncParentDirectory(const QString& filePath)
+{
+#ifdef Q_OS_UNIX
+    const QByteArray dirPath = QFile::encodeName(QFileInfo(filePath).absolutePath());
+    const int fd = ::open(dirPath.constData(), O_RDONLY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+#else
+    Q_UNUSED(filePath);
+#endif
+}
+}
 
 TweetRepository::TweetRepository(QObject *parent) 
-    : QObject(parent), m_currentResourcePath(":/data/SCTweets.json") // Default load path
+    : QObject(parent),
+      m_deletedRowCount(0),
+      m_version(0),
+      m_currentResourcePath(":/data/SCTweets.json"), // Default load path
+      m_loadPool(new QThreadPool(this)),
+      m_loadInProgress(false),
+      m_lastLoadSucceeded(false),
+      m_cancelLoad(false)
+{
+    setMaxLoadThreads(0);
+    connect(&m_saveWatcher, &QFutureWatcher<bool>::finished, this, &TweetRepository::startQueuedWork);
+}
+
+TweetRepository::~TweetRepository()
 {
+    m_cancelLoad = true; // A half-read file is of no use to anyone now
+    m_deferredLoadPath.clear();
+    m_pendingLoad.waitForFinished();
+    waitForPendingSave(); // Queued saves included: they hold the user's changes
+}
+
+void TweetRepository::setMaxLoadThreads(int maxThreads)
+{
+    m_loadPool->setMaxThreadCount(maxThreads > 0 ? maxThreads : QThread::idealThreadCount());
+    qInfo() << "TweetRepository: Using up to" << m_loadPool->maxThreadCount() << "threads for load-time extraction.";
 }
 
 bool TweetRepository::loadTweets(const QString& filePathToLoad)
 {
+    if (m_loadInProgress) {
+        qWarning() << "TweetRepository: A load is already in progress; ignoring request for" << filePathToLoad;
+        return false;
+    }
+
     // If filePathToLoad is empty, use the stored m_currentResourcePath (which defaults to resource)
     QString actualPath = filePathToLoad.isEmpty() ? m_currentResourcePath : filePathToLoad;
     
@@ -27,95 +101,219 @@ bool TweetRepository::loadTweets(const QString& filePathToLoad)
         m_currentResourcePath = actualPath;
     }
 
+    m_loadInProgress = true;
+    m_cancelLoad = false;
+    if (isSaveInProgress()) {
+        // Never read a base file that is being rewritten; startQueuedWork begins once the saves drain
+        m_deferredLoadPath = actualPath;
+        return true;
+    }
+    startLoad(actualPath);
+    return true;
+}
+
+void TweetRepository::startLoad(const QString& actualPath)
+{
+    // Reading, decoding and indexing run off the GUI thread; batches and the finished collection
+    // are handed back through queued calls. The destructor cancels and waits, so 'this' outlives them.
+    m_pendingLoad = QtConcurrent::run([this, actualPath]() {
+        auto reportBatch = [this](const QVector<TweetData>& newRows, qint64 bytesRead, qint64 totalBytes) {
+            QMetaObject::invokeMethod(this, [this, newRows, bytesRead, totalBytes]() {
+                emit loadProgress(bytesRead, totalBytes);
+                if (!newRows.isEmpty()) emit tweetsBatchLoaded(newRows);
+            }, Qt::QueuedConnection);
+        };
+        LoadResult result = readTweetFile(actualPath, m_loadPool, m_cancelLoad, reportBatch);
+        if (m_cancelLoad) return;
+        QMetaObject::invokeMethod(this, [this, actualPath, result = std::move(result)]() mutable {
+            applyLoadResult(actualPath, result);
+        }, Qt::QueuedConnection);
+    });
+}
+
+TweetRepository::LoadResult TweetRepository::readTweetFile(const QString& actualPath, QThreadPool* pool,
+                                                           const std::atomic<bool>& cancelled, const BatchCallback& onBatch)
+{
+    LoadResult result;
     QFile jsonFile(actualPath);
     qInfo() << "TweetRepository: Attempting to load tweets from:" << actualPath;
 
     if (!jsonFile.exists()) { // Check existence first for clearer error if it's a user file
         qWarning() << "TweetRepository: File does not exist -" << actualPath;
-        if (!actualPath.startsWith(":/")) { // Only emit error for non-resource paths, resource path failure handled below
-             emit loadError("Load Error", "Tweet file not found:\n" + actualPath);
+        if (!actualPath.startsWith(":/")) { // Only report for non-resource paths, the caller handles a missing resource
+            result.errorTitle = "Load Error";
+            result.errorMessage = "Tweet file not found:\n" + actualPath;
         }
-        return false;
+        return result;
+    }
+    result.totalBytes = jsonFile.size();
+
+    // Fast path: a snapshot that still matches the source skips JSON decoding and UGen extraction entirely
+    const QString snapshotPath = TweetSnapshot::snapshotPathFor(actualPath);
+    QVector<TweetData> loadedTweets;
+    if (TweetSnapshot::read(snapshotPath, actualPath, loadedTweets)) {
+        // UGens come precomputed; the search fields are process-local and cheap, so derive them here
+        QtConcurrent::blockingMap(pool, loadedTweets, &TweetRepository::deriveSearchFields);
+        for (TweetData& tweet : loadedTweets) internSymbols(tweet);
+        qInfo() << "TweetRepository: Read" << loadedTweets.size() << "tweets from snapshot" << snapshotPath;
+        result.tweets = std::move(loadedTweets);
+        buildIndexes(result.tweets, result.rowById, result.facets, result.trigrams, result.searchKeys, result.deletedRowCount);
+        result.ok = true;
+        return result;
     }
 
-    if (!jsonFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (!jsonFile.open(QIODevice::ReadOnly)) {
         qWarning() << "TweetRepository: Failed to open" << actualPath << ":" << jsonFile.errorString();
-        emit loadError("Load Error", "Could not open tweet file:\n" + actualPath);
-        return false;
+        result.errorTitle = "Load Error";
+        result.errorMessage = "Could not open tweet file:\n" + actualPath;
+        return result;
     }
 
-    QByteArray jsonData = jsonFile.readAll();
-    jsonFile.close();
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(jsonData, &parseError);
+    TweetJsonStreamReader reader(&jsonFile);
+    if (!reader.begin()) {
+        qWarning() << "TweetRepository: Failed to parse JSON from" << actualPath << ":" << reader.errorString();
+        result.errorTitle = "JSON Error";
+        result.errorMessage = "Failed to parse tweet file:\n" + actualPath + "\n" + reader.errorString();
+        return result;
+    }
 
-    if (parseError.error != QJsonParseError::NoError) {
-        qWarning() << "TweetRepository: Failed to parse JSON from" << actualPath << ":" << parseError.errorString();
-        emit loadError("JSON Error", "Failed to parse tweet file:\n" + actualPath + "\n" + parseError.errorString());
-        return false;
+    // Decode into a fresh vector so a malformed file leaves the current collection untouched.
+    // This thread decodes and feeds batches to the load pool: while the pool derives batch N,
+    // the reader decodes batch N+1. Results are merged back in file order.
+    QHash<QString, int> rowById; // Duplicate keys: the last one wins, as with QJsonObject
+    QVector<TweetData> decodedBatch;
+    QVector<TweetData> derivingBatch;
+    QFuture<void> deriving;
+
+    auto mergeDerivingBatch = [&]() {
+        deriving.waitForFinished();
+        if (derivingBatch.isEmpty()) return;
+        for (TweetData& tweet : derivingBatch) {
+            internSymbols(tweet); // Single-threaded so first-seen spellings are deterministic
+        }
+        // A repeated key replaces its earlier row, which listeners have already seen; only announce new ids
+        QVector<TweetData> newRows;
+        newRows.reserve(derivingBatch.size());
+        for (TweetData& tweet : derivingBatch) {
+            auto existing = rowById.constFind(tweet.id);
+            if (existing != rowById.constEnd()) {
+                loadedTweets[existing.value()] = std::move(tweet);
+            } else {
+                rowById.insert(tweet.id, loadedTweets.size());
+                loadedTweets.append(std::move(tweet));
+                newRows.append(loadedTweets.constLast()); // Implicitly shared with the stored row
+            }
+        }
+        derivingBatch.clear();
+        onBatch(newRows, reader.bytesConsumed(), reader.totalBytes());
+    };
+    auto dispatchDecodedBatch = [&]() {
+        mergeDerivingBatch();
+        derivingBatch.swap(decodedBatch);
+        deriving = QtConcurrent::map(pool, derivingBatch, &TweetRepository::deriveTweetData);
+    };
+
+    TweetData td;
+    while (!cancelled && reader.readNext(td)) {
+        if (td.isDeleted()) { // An empty key would read as a tombstone
+            qWarning() << "TweetRepository: Item with an empty key. Skipping.";
+            continue;
+        }
+        decodedBatch.append(std::move(td));
+        if (decodedBatch.size() == kLoadBatchSize) {
+            dispatchDecodedBatch();
+        }
     }
-    if (!doc.isObject()) {
-        qWarning() << "TweetRepository: JSON root is not an object in" << actualPath;
-        emit loadError("JSON Error", "Tweet file root is not a valid JSON object:\n" + actualPath);
-        return false;
+    jsonFile.close();
+    if (cancelled) {
+        deriving.waitForFinished(); // The pool still references derivingBatch
+        return result;
+    }
+    dispatchDecodedBatch();
+    mergeDerivingBatch();
+
+    if (reader.hasError()) {
+        qWarning() << "TweetRepository: Failed to parse JSON from" << actualPath << ":" << reader.errorString();
+        result.errorTitle = "JSON Error";
+        result.errorMessage = "Failed to parse tweet file:\n" + actualPath + "\n" + reader.errorString();
+        return result;
     }
 
-    QJsonObject rootObj = doc.object();
-    m_tweets.clear(); // Clear existing tweets before loading new set
+    // QJsonObject used to hand the keys back sorted; keep that listing order
+    std::sort(loadedTweets.begin(), loadedTweets.end(),
+              [](const TweetData& a, const TweetData& b) { return a.id < b.id; });
+    // Base file only; the journal is replayed on top
+    TweetSnapshot::write(snapshotPath, actualPath, TweetSnapshot::hashSourceFile(actualPath), loadedTweets);
+    result.tweets = std::move(loadedTweets);
+    buildIndexes(result.tweets, result.rowById, result.facets, result.trigrams, result.searchKeys, result.deletedRowCount);
+    result.totalBytes = reader.totalBytes();
+    result.ok = true;
+    return result;
+}
 
-    for (auto it = rootObj.constBegin(); it != rootObj.constEnd(); ++it) {
-        QString key = it.key();
-        QJsonValue value = it.value();
-        if (!value.isObject()) { 
-            qWarning() << "TweetRepository: Item with key" << key << "is not an object. Skipping.";
-            continue; 
-        }
-        QJsonObject tweetObj = value.toObject();
-        if (!tweetObj.contains("original") || !tweetObj["original"].isString()) { 
-            qWarning() << "TweetRepository: Item with key" << key << "is missing 'original' code. Skipping.";
-            continue; 
-        }
+void TweetRepository::applyLoadResult(const QString& actualPath, LoadResult& result)
+{
+    m_loadInProgress = false;
+    m_lastLoadSucceeded = result.ok;
+    if (!result.ok) {
+        if (!result.errorTitle.isEmpty()) emit loadError(result.errorTitle, result.errorMessage);
+        emit loadFinished(actualPath, false);
+        return;
+    }
 
-        TweetData td;
-        td.id = key;
-        td.originalCode = tweetObj["original"].toString();
-        td.author = tweetObj.value("author").toString("Unknown");
-        td.sourceUrl = tweetObj.value("source_url").toString("");
-        td.description = tweetObj.value("description").toString("-");
-        td.publicationDate = tweetObj.value("publication_date").toString("unknown");
-
-        if (tweetObj.contains("classification") && tweetObj["classification"].isObject()) {
-            QJsonObject classificationObj = tweetObj["classification"].toObject();
-            if (classificationObj.contains("sonic_characteristics") && classificationObj["sonic_characteristics"].isArray()) {
-                QJsonArray sonicArray = classificationObj["sonic_characteristics"].toArray();
-                for (const QJsonValue &tagVal : sonicArray) {
-                    if (tagVal.isString()) td.sonicTags.append(tagVal.toString());
-                }
-            }
-            if (classificationObj.contains("synthesis_techniques") && classificationObj["synthesis_techniques"].isArray()) {
-                QJsonArray techArray = classificationObj["synthesis_techniques"].toArray();
-                for (const QJsonValue &tagVal : techArray) {
-                    if (tagVal.isString()) td.techniqueTags.append(tagVal.toString());
-                }
-            }
-        }
+    m_tweets = std::move(result.tweets);
+    m_rowById = std::move(result.rowById);
+    m_facets = std::move(result.facets);
+    m_trigrams = std::move(result.trigrams);
+    m_searchKeys = std::move(result.searchKeys);
+    m_deletedRowCount = result.deletedRowCount;
+    ++m_version;
+    attachJournal(actualPath);
+
+    emit loadProgress(result.totalBytes, result.totalBytes);
+    qInfo() << "TweetRepository: Loaded" << tweetCount() << "tweets from" << actualPath;
+    emit tweetsLoaded(tweetCount());
+    emit loadFinished(actualPath, true);
+}
 
-        if (tweetObj.contains("tags") && tweetObj["tags"].isArray()) {
-            QJsonArray tagsArray = tweetObj["tags"].toArray();
-            for (const QJsonValue &tagVal : tagsArray) { if (tagVal.isString()) td.genericTags.append(tagVal.toString()); }
-        }
-        
-        extractUgens(td);
-        m_tweets.append(td);
+bool TweetRepository::isLoadInProgress() const
+{
+    return m_loadInProgress;
+}
+
+bool TweetRepository::waitForPendingLoad()
+{
+    if (!m_deferredLoadPath.isEmpty()) {
+        waitForPendingSave();
+        startLoad(std::exchange(m_deferredLoadPath, QString()));
     }
-    qInfo() << "TweetRepository: Loaded" << m_tweets.count() << "tweets from" << actualPath;
-    emit tweetsLoaded(m_tweets.count());
-    return true;
+    m_pendingLoad.waitForFinished();
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall); // Deliver the batches and result the worker queued
+    return !m_loadInProgress && m_lastLoadSucceeded;
+}
+
+void TweetRepository::deriveTweetData(TweetData& tweetData) {
+    extractUgens(tweetData);
+    deriveSearchFields(tweetData);
+}
+
+QString TweetRepository::searchKeyOf(const TweetData& tweetData) {
+    // Newline-separated so a search term never matches across two fields
+    QStringList fields = { tweetData.id, tweetData.originalCode, tweetData.description, tweetData.author };
+    fields << tweetData.sonicTags << tweetData.techniqueTags << tweetData.genericTags;
+    return fields.join(QLatin1Char('\n')).toCaseFolded();
+}
+
+void TweetRepository::deriveSearchFields(TweetData& tweetData) {
+    tweetData.searchKey = searchKeyOf(tweetData);
+    tweetData.codeHash = qHash(tweetData.originalCode);
+    tweetData.publicationDay = publicationDayOf(tweetData.publicationDate);
 }
 
 void TweetRepository::extractUgens(TweetData& tweetData) {
-    QRegularExpression ugenMethodRegex(R"(\b([A-Z][a-zA-Z0-9]*)(?:\.(?:ar|kr|ir|new)\b|\())");
-    QRegularExpression ugenFuncRegex(R"(\b(?:ar|kr|ir|new)\b\s*\(\s*([A-Z][a-zA-Z0-9]*)\b)");
+    // Compiled once and shared; QRegularExpression matching is safe from several threads
+    static const QRegularExpression ugenMethodRegex(R"(\b([A-Z][a-zA-Z0-9]*)(?:\.(?:ar|kr|ir|new)\b|\())");
+    static const QRegularExpression ugenFuncRegex(R"(\b(?:ar|kr|ir|new)\b\s*\(\s*([A-Z][a-zA-Z0-9]*)\b)");
     
     QSet<QString> ugensSet;
     QRegularExpressionMatchIterator i1 = ugenMethodRegex.globalMatch(tweetData.originalCode);
@@ -130,58 +328,146 @@ void TweetRepository::extractUgens(TweetData& tweetData) {
     tweetData.ugens.sort(Qt::CaseInsensitive);
 }
 
+void TweetRepository::internSymbols(TweetData& tweetData) {
+    SymbolTable& symbols = SymbolTable::instance();
+    if (tweetData.author.isEmpty()) {
+        tweetData.authorId = symbols.intern(QStringLiteral("Unknown"));
+    } else {
+        tweetData.authorId = symbols.internShared(tweetData.author);
+    }
+    auto internList = [&symbols](QStringList& values) {
+        for (QString& value : values) symbols.internShared(value);
+    };
+    internList(tweetData.sonicTags);
+    internList(tweetData.techniqueTags);
+    internList(tweetData.genericTags);
+    internList(tweetData.ugens);
+    Q_ASSERT(symbolsInterned(tweetData));
+}
+
+bool TweetRepository::symbolsInterned(const TweetData& tweetData) {
+    const SymbolTable& symbols = SymbolTable::instance();
+    const QString author = tweetData.author.isEmpty() ? QStringLiteral("Unknown") : tweetData.author;
+    if (tweetData.authorId != symbols.lookup(author)) return false;
+    auto listInterned = [&symbols](const QStringList& values) {
+        for (const QString& value : values) {
+            if (symbols.lookup(value) == InvalidSymbolId) return false;
+        }
+        return true;
+    };
+    return listInterned(tweetData.sonicTags) && listInterned(tweetData.techniqueTags) &&
+           listInterned(tweetData.genericTags) && listInterned(tweetData.ugens);
+}
+
 const QVector<TweetData>& TweetRepository::getAllTweets() const {
     return m_tweets;
 }
 
 const TweetData* TweetRepository::findTweetById(const QString& id) const {
-    for (const auto& tweet : m_tweets) {
-        if (tweet.id == id) {
-            return &tweet;
-        }
+    auto it = m_rowById.constFind(id);
+    if (it == m_rowById.constEnd()) {
+        return nullptr;
     }
-    return nullptr;
+    return &m_tweets.at(it.value());
+}
+
+int TweetRepository::tweetCount() const
+{
+    return m_rowById.size();
 }
 
 QSet<QString> TweetRepository::getAllTweetIds() const
 {
-    QSet<QString> ids;
-    for (const auto& tweet : m_tweets) {
-        ids.insert(tweet.id);
-    }
-    return ids;
+    return QSet<QString>(m_rowById.keyBegin(), m_rowById.keyEnd());
 }
 
 QSet<QString> TweetRepository::getAllUniqueAuthors() const {
-    QSet<QString> authors;
-    for (const auto& tweet : m_tweets) {
-        authors.insert(tweet.author.isEmpty() ? "Unknown" : tweet.author);
-    }
-    return authors;
+    return m_facets.values(FacetKind::Author);
 }
 
 QSet<QString> TweetRepository::getAllUniqueSonicTags() const {
-    QSet<QString> sonics;
-    for (const auto& tweet : m_tweets) {
-        for(const QString& tag : tweet.sonicTags) { sonics.insert(tag); }
-    }
-    return sonics;
+    return m_facets.values(FacetKind::SonicTag);
 }
 
 QSet<QString> TweetRepository::getAllUniqueTechniqueTags() const {
-    QSet<QString> techniques;
-    for (const auto& tweet : m_tweets) {
-        for(const QString& tag : tweet.techniqueTags) { techniques.insert(tag); }
-    }
-    return techniques;
+    return m_facets.values(FacetKind::TechniqueTag);
 }
 
 QSet<QString> TweetRepository::getAllUniqueUgens() const {
-    QSet<QString> ugens;
-    for (const auto& tweet : m_tweets) {
-        for(const QString& ugen : tweet.ugens) { ugens.insert(ugen); }
+    return m_facets.values(FacetKind::Ugen);
+}
+
+QHash<QString, int> TweetRepository::getFacetCounts(FacetKind kind) const {
+    return m_facets.countsByText(kind);
+}
+
+const FacetIndex& TweetRepository::facetIndex() const {
+    return m_facets;
+}
+
+const TrigramIndex& TweetRepository::trigramIndex() const {
+    return m_trigrams;
+}
+
+const SearchKeyStore& TweetRepository::searchKeys() const {
+    return m_searchKeys;
+}
+
+RepositorySnapshot TweetRepository::snapshot() const
+{
+    RepositorySnapshot snapshot;
+    snapshot.tweets = m_tweets;
+    snapshot.facets = m_facets;
+    snapshot.trigrams = m_trigrams;
+    snapshot.searchKeys = m_searchKeys;
+    snapshot.version = m_version;
+    return snapshot;
+}
+
+void TweetRepository::rebuildIndexes()
+{
+    buildIndexes(m_tweets, m_rowById, m_facets, m_trigrams, m_searchKeys, m_deletedRowCount);
+    ++m_version;
+}
+
+void TweetRepository::buildIndexes(QVector<TweetData>& rows, QHash<QString, int>& rowById, FacetIndex& facets,
+                                   TrigramIndex& trigrams, SearchKeyStore& searchKeys, int& deletedRowCount)
+{
+    rowById.clear();
+    rowById.reserve(rows.size());
+    facets.clear();
+    trigrams.clear();
+    searchKeys.clear();
+    deletedRowCount = 0;
+    rows.reserve(rows.size() + kRowHeadroom); // Journal replay and typical edits then append without reallocating
+    qsizetype keyBytes = 0;
+    for (const TweetData& tweet : std::as_const(rows)) keyBytes += tweet.searchKey.size(); // ASCII-sized guess
+    searchKeys.reserve(rows.size(), keyBytes);
+    for (int row = 0; row < rows.size(); ++row) {
+        TweetData& tweet = rows[row];
+        if (tweet.isDeleted()) {
+            ++deletedRowCount;
+            continue;
+        }
+        // Fresh loads come with keys derived on the load pool; compacted rows dropped theirs
+        const QString searchKey = tweet.searchKey.isEmpty() ? searchKeyOf(tweet) : tweet.searchKey;
+        rowById.insert(tweet.id, row);
+        facets.addTweet(row, tweet);
+        trigrams.addRow(row, searchKey);
+        searchKeys.setRow(row, searchKey);
+        tweet.searchKey = QString(); // searchKeys holds it from here on, in half the bytes for ASCII
     }
-    return ugens;
+}
+
+void TweetRepository::compactDeletedRows()
+{
+    // Shifts rows, so every outstanding TweetData pointer is invalidated; only done once tombstones
+    // dominate, and always before tweetsModified so listeners re-query.
+    m_tweets.erase(std::remove_if(m_tweets.begin(), m_tweets.end(),
+                                  [](const TweetData& t) { return t.isDeleted(); }),
+                   m_tweets.end());
+    rebuildIndexes();
+    qInfo() << "TweetRepository: Compacted deleted rows," << m_tweets.size() << "rows remain.";
 }
 
 QString TweetRepository::getCurrentResourcePath() const
@@ -189,19 +475,94 @@ QString TweetRepository::getCurrentResourcePath() const
     return m_currentResourcePath;
 }
 
+quint64 TweetRepository::version() const
+{
+    return m_version;
+}
+
+void TweetRepository::insertOrReplaceRow(const TweetData& tweet)
+{
+    Q_ASSERT(symbolsInterned(tweet)); // FacetIndex looks the values up; unknown ones would be skipped
+    ++m_version;
+    auto it = m_rowById.constFind(tweet.id);
+    if (it == m_rowById.constEnd()) {
+        m_tweets.append(tweet); // Reallocates once the headroom from rebuildIndexes is used up
+        const int newRow = m_tweets.size() - 1;
+        m_tweets[newRow].searchKey = QString(); // Stored rows keep theirs only in m_searchKeys
+        m_rowById.insert(tweet.id, newRow);
+        m_facets.addTweet(newRow, tweet);
+        m_trigrams.addRow(newRow, tweet.searchKey);
+        m_searchKeys.setRow(newRow, tweet.searchKey);
+        return;
+    }
+    TweetData& row = m_tweets[it.value()];
+    const QString oldSearchKey = QString::fromUtf8(m_searchKeys.key(it.value()));
+    m_facets.removeTweet(it.value(), row);
+    m_facets.addTweet(it.value(), tweet);
+    m_trigrams.removeRow(it.value(), oldSearchKey);
+    m_trigrams.addRow(it.value(), tweet.searchKey);
+    if (tweet.searchKey != oldSearchKey) m_searchKeys.setRow(it.value(), tweet.searchKey);
+    row = tweet; // In place: the row keeps its number (and its address, unless a snapshot made m_tweets detach)
+    row.searchKey = QString();
+}
+
+bool TweetRepository::removeRow(const QString& tweetId)
+{
+    auto it = m_rowById.find(tweetId);
+    if (it == m_rowById.end()) {
+        return false;
+    }
+    ++m_version;
+    // Leave a tombstone instead of QVector::remove so later rows neither shift nor move
+    m_facets.removeTweet(it.value(), m_tweets.at(it.value()));
+    m_trigrams.removeRow(it.value(), QString::fromUtf8(m_searchKeys.key(it.value())));
+    m_searchKeys.removeRow(it.value());
+    m_tweets[it.value()] = TweetData();
+    m_rowById.erase(it);
+    ++m_deletedRowCount;
+    if (m_deletedRowCount > kMinTombstonesBeforeCompaction && m_deletedRowCount * 2 > m_tweets.size()) {
+        compactDeletedRows();
+    }
+    return true;
+}
+
+qint64 TweetRepository::publicationDayOf(const QString& publicationDate)
+{
+    // Dates are typed by hand in the edit dialog; accept the common spellings, newest detail first
+    static const char* const formats[] = { "yyyy-MM-dd", "yyyy-MM", "yyyy", "d/M/yyyy", "d.M.yyyy" };
+    const QString trimmed = publicationDate.trimmed();
+    for (const char* format : formats) {
+        const QDate date = QDate::fromString(trimmed, QLatin1String(format));
+        if (date.isValid()) return date.toJulianDay();
+    }
+    const QDateTime dateTime = QDateTime::fromString(trimmed, Qt::ISODate);
+    return dateTime.isValid() ? dateTime.date().toJulianDay() : 0;
+}
+
 // --- CRUD METHOD IMPLEMENTATIONS ---
 bool TweetRepository::addTweet(const TweetData& newTweetData)
 {
-    for (const auto& tweet : m_tweets) {
-        if (tweet.id == newTweetData.id) {
-            qWarning() << "TweetRepository: Attempted to add tweet with duplicate ID:" << newTweetData.id;
-            return false; 
-        }
+    if (m_loadInProgress) {
+        qWarning() << "TweetRepository: Cannot add a tweet while a load is in progress.";
+        return false;
+    }
+    if (newTweetData.isDeleted()) {
+        qWarning() << "TweetRepository: Attempted to add tweet with an empty ID.";
+        return false;
+    }
+    if (m_rowById.contains(newTweetData.id)) {
+        qWarning() << "TweetRepository: Attempted to add tweet with duplicate ID:" << newTweetData.id;
+        return false; 
     }
     TweetData tweetToAdd = newTweetData; 
-    extractUgens(tweetToAdd); 
+    deriveTweetData(tweetToAdd); 
+    internSymbols(tweetToAdd);
 
-    m_tweets.append(tweetToAdd);
+    insertOrReplaceRow(tweetToAdd);
+    if (m_journal.isOpen()) {
+        m_journal.appendUpsert(tweetToAdd);
+        compactJournalIfDue();
+    }
     qInfo() << "TweetRepository: Added tweet:" << tweetToAdd.id;
     emit tweetsModified();
     return true;
@@ -209,85 +570,188 @@ bool TweetRepository::addTweet(const TweetData& newTweetData)
 
 bool TweetRepository::updateTweet(const TweetData& updatedTweetData)
 {
-    for (int i = 0; i < m_tweets.size(); ++i) {
-        if (m_tweets[i].id == updatedTweetData.id) {
-            TweetData tweetToUpdate = updatedTweetData; 
-            extractUgens(tweetToUpdate); 
-
-            m_tweets[i] = tweetToUpdate;
-            qInfo() << "TweetRepository: Updated tweet:" << updatedTweetData.id;
-            emit tweetsModified();
-            return true;
-        }
+    if (m_loadInProgress) {
+        qWarning() << "TweetRepository: Cannot update a tweet while a load is in progress.";
+        return false;
+    }
+    if (!m_rowById.contains(updatedTweetData.id)) {
+        qWarning() << "TweetRepository: Attempted to update non-existent tweet ID:" << updatedTweetData.id;
+        return false;
     }
-    qWarning() << "TweetRepository: Attempted to update non-existent tweet ID:" << updatedTweetData.id;
-    return false;
+    TweetData tweetToUpdate = updatedTweetData; 
+    deriveTweetData(tweetToUpdate); 
+    internSymbols(tweetToUpdate);
+
+    insertOrReplaceRow(tweetToUpdate);
+    if (m_journal.isOpen()) {
+        m_journal.appendUpsert(tweetToUpdate);
+        compactJournalIfDue();
+    }
+    qInfo() << "TweetRepository: Updated tweet:" << updatedTweetData.id;
+    emit tweetsModified();
+    return true;
 }
 
 bool TweetRepository::deleteTweet(const QString& tweetId)
 {
-    for (int i = 0; i < m_tweets.size(); ++i) {
-        if (m_tweets[i].id == tweetId) {
-            m_tweets.remove(i);
-            qInfo() << "TweetRepository: Deleted tweet:" << tweetId;
-            emit tweetsModified();
-            return true;
-        }
+    if (m_loadInProgress) {
+        qWarning() << "TweetRepository: Cannot delete a tweet while a load is in progress.";
+        return false;
+    }
+    if (!removeRow(tweetId)) {
+        qWarning() << "TweetRepository: Attempted to delete non-existent tweet ID:" << tweetId;
+        return false;
+    }
+    if (m_journal.isOpen()) {
+        m_journal.appendDelete(tweetId);
+        compactJournalIfDue();
     }
-    qWarning() << "TweetRepository: Attempted to delete non-existent tweet ID:" << tweetId;
-    return false;
+    qInfo() << "TweetRepository: Deleted tweet:" << tweetId;
+    emit tweetsModified();
+    return true;
 }
 
-bool TweetRepository::saveTweetsInternal(const QString& filePath) {
-    QJsonObject rootObj;
-    for (const auto& tweet : m_tweets) {
-        QJsonObject tweetObj;
-        tweetObj["original"] = tweet.originalCode;
-        tweetObj["author"] = tweet.author;
-        tweetObj["source_url"] = tweet.sourceUrl;
-        tweetObj["description"] = tweet.description;
-        tweetObj["publication_date"] = tweet.publicationDate;
-
-        QJsonObject classificationObj;
-        if (!tweet.sonicTags.isEmpty()) {
-            classificationObj["sonic_characteristics"] = QJsonArray::fromStringList(tweet.sonicTags);
-        }
-        if (!tweet.techniqueTags.isEmpty()) {
-            classificationObj["synthesis_techniques"] = QJsonArray::fromStringList(tweet.techniqueTags);
-        }
-        if (!classificationObj.isEmpty()){
-             tweetObj["classification"] = classificationObj;
+// --- JOURNAL ---
+void TweetRepository::attachJournal(const QString& basePath)
+{
+    m_journal.close();
+    if (basePath.startsWith(":/")) {
+        return; // Read-only resource: the first save creates a user file, and its journal
+    }
+    // A leftover .compacting file means the last rewrite never finished; it predates the live journal
+    int replayed = 0;
+    const QStringList journalPaths = { TweetJournal::compactingPathFor(basePath), TweetJournal::journalPathFor(basePath) };
+    for (const QString& journalPath : journalPaths) {
+        const QVector<TweetJournal::Entry> entries = TweetJournal::readEntries(journalPath);
+        for (const TweetJournal::Entry& entry : entries) {
+            if (entry.op == TweetJournal::Entry::Delete) {
+                removeRow(entry.id); // Already gone is fine: replay is idempotent
+                continue;
+            }
+            TweetData tweet = entry.tweet;
+            deriveTweetData(tweet);
+            internSymbols(tweet);
+            insertOrReplaceRow(tweet);
         }
+        replayed += entries.size();
+    }
+    if (replayed > 0) {
+        qInfo() << "TweetRepository: Replayed" << replayed << "journal records onto" << basePath;
+    }
+    m_journal.open(basePath);
+}
 
-        if (!tweet.genericTags.isEmpty()) {
-            tweetObj["tags"] = QJsonArray::fromStringList(tweet.genericTags);
-        }
-        rootObj[tweet.id] = tweetObj;
+void TweetRepository::compactJournalIfDue()
+{
+    if (m_journal.pendingEntryCount() >= kJournalCompactionThreshold && !m_pendingSave.isRunning()) {
+        saveTweetsInternal(m_journal.basePath());
     }
+}
 
-    QJsonDocument doc(rootObj);
-    QFile jsonFile(filePath);
+bool TweetRepository::writeCorpusFile(const QString& filePath, const QVector<TweetData>& rows, QString& errorString)
+{
+    const QByteArray jsonData = TweetJournal::encodeCorpus(rows);
+    // QSaveFile writes a temporary file next to filePath and renames it over the old one on
+    // commit, so an interrupted save leaves the previous file intact, never a truncated one
+    QSaveFile jsonFile(filePath);
+    if (!jsonFile.open(QIODevice::WriteOnly)) {
+        errorString = jsonFile.errorString();
+        return false;
+    }
+    if (jsonFile.write(jsonData) != jsonData.size() || !syncToDisk(jsonFile) || !jsonFile.commit()) {
+        errorString = jsonFile.errorString();
+        jsonFile.cancelWriting();
+        return false;
+    }
+    syncParentDirectory(filePath); // Make the rename itself durable
+    writeSnapshotFor(filePath, jsonData, rows);
+    return true;
+}
 
+void TweetRepository::writeSnapshotFor(const QString& filePath, const QByteArray& jsonData, const QVector<TweetData>& rows)
+{
+    // Refresh the snapshot so the next launch can skip parsing what was just written.
+    // Rows are stored in the same id order a JSON load would produce.
+    QVector<TweetData> snapshotRows;
+    snapshotRows.reserve(rows.size());
+    for (const auto& tweet : rows) {
+        if (!tweet.isDeleted()) snapshotRows.append(tweet);
+    }
+    std::sort(snapshotRows.begin(), snapshotRows.end(),
+              [](const TweetData& a, const TweetData& b) { return a.id < b.id; });
+    TweetSnapshot::write(TweetSnapshot::snapshotPathFor(filePath), filePath, TweetSnapshot::hashSourceData(jsonData), snapshotRows);
+}
+
+bool TweetRepository::saveTweetsInternal(const QString& filePath) {
     if (filePath.startsWith(":/")) {
         qCritical() << "TweetRepository: CRITICAL - Cannot save tweets to a Qt Resource Path like" << filePath;
         emit loadError("Save Error", "Cannot save to read-only resource path.\nDeveloper: Fix save path logic.");
         return false;
     }
 
-    if (!jsonFile.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
-        qWarning() << "TweetRepository: Failed to open file for writing:" << filePath << jsonFile.errorString();
-        emit loadError("Save Error", "Could not open file for saving tweets:\n" + filePath);
-        return false;
+    if (m_pendingSave.isRunning()) {
+        // One writer per file: the .compacting file belongs to the running save. startQueuedWork
+        // runs this again when it finishes, with the rows as they are then.
+        if (!m_queuedSavePaths.contains(filePath)) m_queuedSavePaths.append(filePath);
+        return true;
     }
 
-    jsonFile.write(doc.toJson(QJsonDocument::Indented));
-    jsonFile.close();
-    qInfo() << "TweetRepository: Successfully saved" << m_tweets.count() << "tweets to" << filePath;
-    // emit tweetsModified(); // Not strictly necessary after save unless order changed or file system interaction is key
+    // Anything journaled so far is about to land in the base file; move it aside so records
+    // appended while the worker writes survive into the next save. A journal found next to
+    // a new target is stale and gets folded away the same way.
+    if (m_journal.basePath() != filePath && !m_journal.open(filePath)) {
+        qWarning() << "TweetRepository: Changes to" << filePath << "will not be journaled.";
+    }
+    QString compactingPath;
+    if (m_journal.isOpen()) {
+        if (!m_journal.rotateForCompaction()) {
+            emit loadError("Save Error", "Could not rotate the change journal for:\n" + filePath +
+                           "\nYour changes are kept in the journal.");
+            return false;
+        }
+        compactingPath = TweetJournal::compactingPathFor(filePath);
+    }
+
+    const QVector<TweetData> rows = m_tweets; // Implicitly shared; later edits detach on this thread
+    const int savedCount = tweetCount();
+    m_pendingSave = QtConcurrent::run([this, filePath, compactingPath, rows, savedCount]() {
+        QString errorString;
+        const bool ok = writeCorpusFile(filePath, rows, errorString);
+        if (ok) {
+            if (!compactingPath.isEmpty()) QFile::remove(compactingPath);
+            qInfo() << "TweetRepository: Successfully saved" << savedCount << "tweets to" << filePath;
+        } else {
+            // The .compacting file stays and is replayed on load or folded into the next save
+            qWarning() << "TweetRepository: Failed to save" << filePath << ":" << errorString;
+        }
+        // Report on the repository's thread; the destructor waits for us, so 'this' outlives the call
+        QMetaObject::invokeMethod(this, [this, ok, filePath, savedCount, errorString]() {
+            if (ok) emit saveFinished(filePath, savedCount);
+            else emit saveFailed(filePath, errorString);
+        }, Qt::QueuedConnection);
+        return ok;
+    });
+    m_saveWatcher.setFuture(m_pendingSave);
     return true;
 }
 
+void TweetRepository::startQueuedWork()
+{
+    while (!m_pendingSave.isRunning() && !m_queuedSavePaths.isEmpty()) {
+        saveTweetsInternal(m_queuedSavePaths.takeFirst()); // Back here when it finishes; a failure to start was reported
+    }
+    if (!m_pendingSave.isRunning() && !m_deferredLoadPath.isEmpty()) {
+        startLoad(std::exchange(m_deferredLoadPath, QString()));
+    }
+}
+
 bool TweetRepository::saveTweetsToResource(const QString& filePathToSaveTo) {
+    if (m_loadInProgress) {
+        // The rows are still the previous collection (or none); writing them now would clobber the file being read
+        qWarning() << "TweetRepository: Not saving while a load is in progress.";
+        return false;
+    }
+
     QString savePath = filePathToSaveTo;
 
     if (savePath.isEmpty()) { // If no path provided, use the current one
@@ -314,5 +778,34 @@ bool TweetRepository::saveTweetsToResource(const QString& filePathToSaveTo) {
         m_currentResourcePath = savePath; // IMPORTANT: Update current path to the user file
     }
     
+    if (m_journal.isOpen() && savePath == m_journal.basePath() && QFile::exists(savePath)) {
+        // Every change since the base file was written sits in the journal (or a .compacting file
+        // from an unfinished rewrite), and both are replayed on load; syncing the journal is the
+        // whole save. Rewriting the base file is left to compactJournalIfDue.
+        const bool synced = m_journal.flush();
+        const int savedCount = tweetCount();
+        const QString journalPath = TweetJournal::journalPathFor(savePath);
+        // Queued like the background writer's report, so callers see the same order either way
+        QMetaObject::invokeMethod(this, [this, synced, savePath, savedCount, journalPath]() {
+            if (synced) emit saveFinished(savePath, savedCount);
+            else emit saveFailed(savePath, "Could not sync the change journal:\n" + journalPath);
+        }, Qt::QueuedConnection);
+        compactJournalIfDue();
+        return true;
+    }
     return saveTweetsInternal(savePath);
-}
\ No newline at end of file
+}
+
+bool TweetRepository::isSaveInProgress() const
+{
+    return m_pendingSave.isRunning() || !m_queuedSavePaths.isEmpty();
+}
+
+void TweetRepository::waitForPendingSave()
+{
+    m_pendingSave.waitForFinished();
+    while (!m_queuedSavePaths.isEmpty()) {
+        saveTweetsInternal(m_queuedSavePaths.takeFirst());
+        m_pendingSave.waitForFinished();
+    }
+}
@@ -2,20 +2,55 @@
 #define TWEETREPOSITORY_H
 
 #include "tweetdata.h"
+#include "facetindex.h"
+#include "trigramindex.h"
+#include "searchkeystore.h"
+#include "tweetjournal.h"
 #include <QVector>
 #include <QString>
 #include <QObject>
 #include <QSet> // For getAllTweetIds
+#include <QHash>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <atomic>
+#include <functional>
+
+QT_BEGIN_NAMESPACE
+class QThreadPool;
+QT_END_NAMESPACE
+
+// Implicitly shared copies of the rows and their indexes, so taking one is O(1) and it can be
+// read on another thread while the repository keeps changing; the first change after a
+// snapshot detaches (copies) the repository's side, never the snapshot's.
+struct RepositorySnapshot {
+    QVector<TweetData> tweets;
+    FacetIndex facets;
+    TrigramIndex trigrams;
+    SearchKeyStore searchKeys;
+    quint64 version = 0; // TweetRepository::version() when taken
+};
 
 class TweetRepository : public QObject
 {
     Q_OBJECT
 public:
     explicit TweetRepository(QObject *parent = nullptr);
+    ~TweetRepository() override; // Cancels a running load, waits for pending and queued saves
 
+    // Reads the file on a worker thread, once pending saves are written, and returns at once.
+    // Progress and rows arrive through loadProgress and tweetsBatchLoaded, then tweetsLoaded (or
+    // loadError), then loadFinished. Until then the previous collection stays in place and edits
+    // and saves are refused. Returns false only if a load is already running.
     bool loadTweets(const QString& resourcePath = ":/data/SCTweets.json");
-    const QVector<TweetData>& getAllTweets() const;
+    bool isLoadInProgress() const;
+    bool waitForPendingLoad(); // Blocks and delivers the queued signals; true if the load succeeded. For tools, not the GUI
+    const QVector<TweetData>& getAllTweets() const; // May contain deleted rows, see TweetData::isDeleted()
+    // O(1) via the id index. The pointer, like those in filter results, is only good until the next
+    // change: an add can reallocate the rows, compaction moves them, and any change while a
+    // snapshot() shares them detaches them. Keep the id, not the pointer, across changes.
     const TweetData* findTweetById(const QString& id) const;
+    int tweetCount() const; // Live tweets only
     QSet<QString> getAllTweetIds() const; // For uniqueness checks
 
     // For populating filters
@@ -23,25 +58,101 @@ public:
     QSet<QString> getAllUniqueSonicTags() const;
     QSet<QString> getAllUniqueTechniqueTags() const;
     QSet<QString> getAllUniqueUgens() const;
+    QHash<QString, int> getFacetCounts(FacetKind kind) const; // Value -> live tweets carrying it
+    const FacetIndex& facetIndex() const;
+    const TrigramIndex& trigramIndex() const; // Over the rows' search keys (TweetData::searchKey), rows of getAllTweets()
+    const SearchKeyStore& searchKeys() const; // The same keys in one UTF-8 buffer, for substring checks
     QString getCurrentResourcePath() const;
+    quint64 version() const; // Bumped on every row change; equal versions mean identical rows
+    RepositorySnapshot snapshot() const;
+
+    // Caps the worker threads used for per-tweet derived data at load time (<= 0: one per core)
+    void setMaxLoadThreads(int maxThreads);
 
     // --- NEW METHODS FOR CRUD ---
     bool addTweet(const TweetData& newTweet);
     bool updateTweet(const TweetData& updatedTweet); // Assumes ID in updatedTweet matches existing
     bool deleteTweet(const QString& tweetId);
+    // Syncs the change journal when saving to the file it belongs to; otherwise (first save out
+    // of the resource, another path) starts a background write of the whole file, queued behind
+    // one still running. The outcome arrives as saveFinished or saveFailed. Returns false only if
+    // the save could not be started (already reported through loadError) or a load is running.
     bool saveTweetsToResource(const QString& resourcePath = ":/data/SCTweets.json"); // Or to a user file path
+    bool isSaveInProgress() const; // Running or queued behind the running one
+    void waitForPendingSave(); // Blocks until every queued save is written; for exit and tools
 
 signals:
     void loadError(const QString& title, const QString& message);
     void tweetsLoaded(int count);
+    void loadProgress(qint64 bytesRead, qint64 totalBytes); // Emitted while streaming a tweet file
+    // Every few hundred decoded tweets, in file order, before tweetsLoaded; each id is announced
+    // once, even if the file repeats its key. Only the rows are ready: findTweetById and the
+    // indexes still answer for the previous collection.
+    void tweetsBatchLoaded(const QVector<TweetData>& batch);
     void tweetsModified(); // *** NEW SIGNAL *** emitted after add, update, delete, save
+    void saveFinished(const QString& filePath, int tweetCount);
+    void saveFailed(const QString& filePath, const QString& errorMessage);
+    void loadFinished(const QString& filePath, bool ok); // Last signal of every loadTweets call
 
 private:
-    void extractUgens(TweetData& tweetData);
-    bool saveTweetsInternal(const QString& filePath); // Helper for saving
+    // Built off the GUI thread by readTweetFile, swapped in by applyLoadResult
+    struct LoadResult {
+        bool ok = false;
+        QString errorTitle; // Empty on a quiet failure (missing resource)
+        QString errorMessage;
+        QVector<TweetData> tweets;
+        QHash<QString, int> rowById;
+        FacetIndex facets;
+        TrigramIndex trigrams;
+        SearchKeyStore searchKeys;
+        int deletedRowCount = 0;
+        qint64 totalBytes = 0;
+    };
+    using BatchCallback = std::function<void(const QVector<TweetData>& newRows, qint64 bytesRead, qint64 totalBytes)>;
+    static LoadResult readTweetFile(const QString& filePath, QThreadPool* pool,
+                                    const std::atomic<bool>& cancelled, const BatchCallback& onBatch);
+    void startLoad(const QString& filePath);
+    void applyLoadResult(const QString& filePath, LoadResult& result);
+    void startQueuedWork(); // When a background save finishes: the next queued save, else a deferred load
+
+    // Thread-safe, run on the load pool: UGen list, folded search key, code hash
+    static void deriveTweetData(TweetData& tweetData);
+    static void deriveSearchFields(TweetData& tweetData);
+    static QString searchKeyOf(const TweetData& tweetData);
+    static void extractUgens(TweetData& tweetData);
+    static qint64 publicationDayOf(const QString& publicationDate); // 0 if it does not parse
+    static void internSymbols(TweetData& tweetData); // Thread-safe, but call it from one thread per load for stable spellings
+    static bool symbolsInterned(const TweetData& tweetData); // Every value is in the SymbolTable; for Q_ASSERT
+    bool saveTweetsInternal(const QString& filePath); // Full rewrite: rotates the journal and hands the write to a worker, or queues behind the running one
+    static bool writeCorpusFile(const QString& filePath, const QVector<TweetData>& rows, QString& errorString); // Thread-safe
+    static void writeSnapshotFor(const QString& filePath, const QByteArray& jsonData, const QVector<TweetData>& rows);
+    void attachJournal(const QString& basePath); // Replays, then keeps appending to, basePath's journal
+    void compactJournalIfDue();
+    void insertOrReplaceRow(const TweetData& tweet); // Already derived and interned
+    bool removeRow(const QString& tweetId);
+    void rebuildIndexes(); // Id, facet, trigram and search-key indexes, after compaction
+    static void buildIndexes(QVector<TweetData>& rows, QHash<QString, int>& rowById, FacetIndex& facets,
+                             TrigramIndex& trigrams, SearchKeyStore& searchKeys, int& deletedRowCount);
+    void compactDeletedRows();
 
     QVector<TweetData> m_tweets;
+    QHash<QString, int> m_rowById; // Tweet id -> row in m_tweets, live rows only
+    FacetIndex m_facets;           // Per-value counts over live rows
+    TrigramIndex m_trigrams;       // Search-box candidates over live rows
+    SearchKeyStore m_searchKeys;   // Live rows' search keys, contiguous
+    int m_deletedRowCount;         // Tombstones currently in m_tweets
+    quint64 m_version;             // See version()
     QString m_currentResourcePath; // Store the path used for loading/saving
+    QThreadPool* m_loadPool;       // Private so a capped load never competes with QThreadPool::globalInstance() users
+    TweetJournal m_journal;        // Open only while m_currentResourcePath is a writable file
+    QFuture<bool> m_pendingSave;   // Background write of the base file, see saveTweetsInternal
+    QFutureWatcher<bool> m_saveWatcher; // Watches m_pendingSave, see startQueuedWork
+    QStringList m_queuedSavePaths; // Saves requested while one was running, in order
+    QFuture<void> m_pendingLoad;   // Background read, see loadTweets
+    QString m_deferredLoadPath;    // A load waiting for the saves to drain
+    bool m_loadInProgress;         // From loadTweets until its result is applied on this thread
+    bool m_lastLoadSucceeded;
+    std::atomic<bool> m_cancelLoad; // Set by the destructor; the reader checks it between tweets
     friend class MainWindow;
 };
 
@@ -0,0 +1,331 @@
+#include "tweetsnapshot.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QHash>
+#include <QDebug>
+#include <cstring> // For memcpy/memcmp
+
+namespace {
+
+const char kMagic[8] = { 'S', 'C', 'T', 'W', 'S', 'N', 'A', 'P' };
+const quint32 kFormatVersion = 2;        // Bump whenever Header/Record or TweetData derivation changes
+const quint32 kEndianMarker = 0x01020304; // Snapshots are host-endian; a foreign file simply fails validation
+const int kHashSize = 20;                 // SHA-1
+
+struct Header {
+    char magic[8];
+    quint32 version;
+    quint32 endianMarker;
+    quint8 sourceHash[kHashSize];
+    quint32 recordCount;
+    quint32 stringCount;
+    quint32 listEntryCount;
+    quint64 stringIndexOffset; // stringCount x StringEntry
+    quint64 stringDataOffset;  // UTF-16 payload
+    quint64 recordsOffset;     // recordCount x Record
+    quint64 listsOffset;       // listEntryCount x quint32 string id
+    quint64 fileSize;
+    quint64 sourceSize;
+    qint64 sourceModified;     // Msecs since the epoch; 0 when unknown, which always forces the hash check
+};
+static_assert(sizeof(Header) == 104, "Snapshot header layout changed");
+
+struct StringEntry {
+    quint32 offset; // In UTF-16 units from stringDataOffset
+    quint32 length;
+};
+
+struct ListRef {
+    quint32 first;
+    quint32 count;
+};
+
+struct Record {
+    quint32 id;
+    quint32 originalCode;
+    quint32 author;
+    quint32 sourceUrl;
+    quint32 description;
+    quint32 publicationDate;
+    ListRef sonicTags;
+    ListRef techniqueTags;
+    ListRef genericTags;
+    ListRef ugens;
+};
+static_assert(sizeof(Record) == 56, "Snapshot record layout changed");
+
+struct SourceStamp {
+    quint64 size = 0;
+    qint64 modified = 0;
+};
+
+SourceStamp stampOf(const QString& sourcePath)
+{
+    const QFileInfo info(sourcePath);
+    const QDateTime modified = info.lastModified();
+    return { quint64(info.size()), modified.isValid() ? modified.toMSecsSinceEpoch() : 0 };
+}
+
+void padTo8(QByteArray& out)
+{
+    while (out.size() % 8 != 0) out.append('\0');
+}
+
+template <typename T>
+void appendPod(QByteArray& out, const T& value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Checks that [offset, offset + count * elementSize) lies inside the mapped file
+bool rangeFits(quint64 offset, quint64 count, quint64 elementSize, quint64 fileSize)
+{
+    if (offset > fileSize) return false;
+    if (elementSize != 0 && count > (fileSize - offset) / elementSize) return false;
+    return true;
+}
+
+class StringInterner
+{
+public:
+    quint32 intern(const QString& s)
+    {
+        auto it = m_ids.constFind(s);
+        if (it != m_ids.constEnd()) return it.value();
+        const quint32 id = quint32(m_entries.size());
+        StringEntry entry { quint32(m_payload.size()), quint32(s.size()) };
+        m_entries.append(entry);
+        m_payload.append(s);
+        m_ids.insert(s, id);
+        return id;
+    }
+    ListRef internList(const QStringList& list, QVector<quint32>& listEntries)
+    {
+        ListRef ref { quint32(listEntries.size()), quint32(list.size()) };
+        for (const QString& s : list) listEntries.append(intern(s));
+        return ref;
+    }
+    const QVector<StringEntry>& entries() const { return m_entries; }
+    const QString& payload() const { return m_payload; }
+
+private:
+    QHash<QString, quint32> m_ids;
+    QVector<StringEntry> m_entries;
+    QString m_payload;
+};
+
+} // namespace
+
+QString TweetSnapshot::snapshotPathFor(const QString& sourcePath)
+{
+    if (sourcePath.startsWith(":/")) {
+        // Bundled resource: cache it in the user's data directory
+        const QString appDataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        if (appDataPath.isEmpty()) return QString();
+        return appDataPath + "/SCTweets_resource.snapshot";
+    }
+    QFileInfo info(sourcePath);
+    return info.path() + "/" + info.completeBaseName() + ".snapshot";
+}
+
+QByteArray TweetSnapshot::hashSourceFile(const QString& sourcePath)
+{
+    QFile file(sourcePath);
+    if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (uchar* mapped = file.map(0, file.size())) { // Resources and regular files both map; fall back to streaming otherwise
+        hash.addData(QByteArrayView(reinterpret_cast<const char*>(mapped), file.size()));
+        file.unmap(mapped);
+    } else if (!hash.addData(&file)) {
+        return QByteArray();
+    }
+    return hash.result();
+}
+
+QByteArray TweetSnapshot::hashSourceData(const QByteArray& sourceData)
+{
+    return QCryptographicHash::hash(sourceData, QCryptographicHash::Sha1);
+}
+
+bool TweetSnapshot::read(const QString& snapshotPath, const QString& sourcePath, QVector<TweetData>& out)
+{
+    if (snapshotPath.isEmpty()) return false;
+
+    QFile file(snapshotPath);
+    if (!file.exists() || !file.open(QIODevice::ReadOnly)) return false;
+    const quint64 fileSize = quint64(file.size());
+    if (fileSize < sizeof(Header)) return false;
+
+    uchar* base = file.map(0, file.size());
+    if (!base) {
+        qWarning() << "TweetSnapshot: Could not map" << snapshotPath << file.errorString();
+        return false;
+    }
+
+    // Every early return below must unmap; keep the parsing in a lambda so that happens in one place
+    auto parse = [&]() -> bool {
+        Header h;
+        std::memcpy(&h, base, sizeof(Header));
+        if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) return false;
+        if (h.version != kFormatVersion || h.endianMarker != kEndianMarker) {
+            qInfo() << "TweetSnapshot: Ignoring snapshot with format version" << h.version << "in" << snapshotPath;
+            return false;
+        }
+        if (h.fileSize != fileSize) return false; // Truncated or foreign file
+        // Size and time decide without reading the source; only a touched or replaced file is hashed
+        const SourceStamp stamp = stampOf(sourcePath);
+        if (stamp.modified == 0 || stamp.size != h.sourceSize || stamp.modified != h.sourceModified) {
+            const QByteArray sourceHash = hashSourceFile(sourcePath);
+            if (sourceHash.size() != kHashSize || std::memcmp(h.sourceHash, sourceHash.constData(), kHashSize) != 0) {
+                qInfo() << "TweetSnapshot: Source file changed since" << snapshotPath << "was written.";
+                return false;
+            }
+        }
+        if (h.stringDataOffset % 2 != 0) return false; // QChar payload must stay aligned
+        if (!rangeFits(h.stringIndexOffset, h.stringCount, sizeof(StringEntry), fileSize) ||
+            !rangeFits(h.recordsOffset, h.recordCount, sizeof(Record), fileSize) ||
+            !rangeFits(h.listsOffset, h.listEntryCount, sizeof(quint32), fileSize) ||
+            h.stringDataOffset > fileSize) {
+            return false;
+        }
+
+        // Copy each interned string out once; records then share them through implicit sharing
+        const quint64 payloadUnits = (fileSize - h.stringDataOffset) / 2;
+        const QChar* payload = reinterpret_cast<const QChar*>(base + h.stringDataOffset);
+        QVector<QString> strings;
+        strings.reserve(h.stringCount);
+        for (quint32 i = 0; i < h.stringCount; ++i) {
+            StringEntry e;
+            std::memcpy(&e, base + h.stringIndexOffset + quint64(i) * sizeof(StringEntry), sizeof(StringEntry));
+            if (quint64(e.offset) + e.length > payloadUnits) return false;
+            strings.append(QString(payload + e.offset, e.length));
+        }
+
+        const quint32* lists = reinterpret_cast<const quint32*>(base + h.listsOffset);
+        auto stringAt = [&](quint32 id, QString& target) {
+            if (id >= quint32(strings.size())) return false;
+            target = strings.at(id);
+            return true;
+        };
+        auto listAt = [&](const ListRef& ref, QStringList& target) {
+            if (quint64(ref.first) + ref.count > h.listEntryCount) return false;
+            target.reserve(ref.count);
+            for (quint32 k = 0; k < ref.count; ++k) {
+                quint32 id;
+                std::memcpy(&id, lists + ref.first + k, sizeof(quint32));
+                if (id >= quint32(strings.size())) return false;
+                target.append(strings.at(id));
+            }
+            return true;
+        };
+
+        QVector<TweetData> tweets;
+        tweets.reserve(h.recordCount);
+        for (quint32 i = 0; i < h.recordCount; ++i) {
+            Record r;
+            std::memcpy(&r, base + h.recordsOffset + quint64(i) * sizeof(Record), sizeof(Record));
+            TweetData td;
+            if (!stringAt(r.id, td.id) || !stringAt(r.originalCode, td.originalCode) ||
+                !stringAt(r.author, td.author) || !stringAt(r.sourceUrl, td.sourceUrl) ||
+                !stringAt(r.description, td.description) || !stringAt(r.publicationDate, td.publicationDate) ||
+                !listAt(r.sonicTags, td.sonicTags) || !listAt(r.techniqueTags, td.techniqueTags) ||
+                !listAt(r.genericTags, td.genericTags) || !listAt(r.ugens, td.ugens)) {
+                return false;
+            }
+            tweets.append(std::move(td));
+        }
+        out = std::move(tweets);
+        return true;
+    };
+
+    const bool ok = parse();
+    file.unmap(base);
+    if (!ok) {
+        qWarning() << "TweetSnapshot: Snapshot" << snapshotPath << "is stale or invalid; falling back to JSON.";
+    }
+    return ok;
+}
+
+bool TweetSnapshot::write(const QString& snapshotPath, const QString& sourcePath, const QByteArray& sourceHash,
+                          const QVector<TweetData>& tweets)
+{
+    if (snapshotPath.isEmpty() || sourceHash.size() != kHashSize) return false;
+
+    StringInterner interner;
+    QVector<quint32> listEntries;
+    QVector<Record> records;
+    records.reserve(tweets.size());
+    for (const TweetData& td : tweets) {
+        Record r;
+        r.id = interner.intern(td.id);
+        r.originalCode = interner.intern(td.originalCode);
+        r.author = interner.intern(td.author);
+        r.sourceUrl = interner.intern(td.sourceUrl);
+        r.description = interner.intern(td.description);
+        r.publicationDate = interner.intern(td.publicationDate);
+        r.sonicTags = interner.internList(td.sonicTags, listEntries);
+        r.techniqueTags = interner.internList(td.techniqueTags, listEntries);
+        r.genericTags = interner.internList(td.genericTags, listEntries);
+        r.ugens = interner.internList(td.ugens, listEntries);
+        records.append(r);
+    }
+
+    Header h;
+    std::memset(&h, 0, sizeof(Header));
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kFormatVersion;
+    h.endianMarker = kEndianMarker;
+    std::memcpy(h.sourceHash, sourceHash.constData(), kHashSize);
+    const SourceStamp stamp = stampOf(sourcePath);
+    h.sourceSize = stamp.size;
+    h.sourceModified = stamp.modified;
+    h.recordCount = quint32(records.size());
+    h.stringCount = quint32(interner.entries().size());
+    h.listEntryCount = quint32(listEntries.size());
+
+    QByteArray out;
+    out.append(reinterpret_cast<const char*>(&h), sizeof(Header)); // Patched with offsets below
+
+    h.stringIndexOffset = quint64(out.size());
+    for (const StringEntry& e : interner.entries()) appendPod(out, e);
+    padTo8(out);
+
+    h.recordsOffset = quint64(out.size());
+    for (const Record& r : records) appendPod(out, r);
+    padTo8(out);
+
+    h.listsOffset = quint64(out.size());
+    for (quint32 id : listEntries) appendPod(out, id);
+    padTo8(out);
+
+    h.stringDataOffset = quint64(out.size());
+    const QString& payload = interner.payload();
+    out.append(reinterpret_cast<const char*>(payload.constData()), payload.size() * qsizetype(sizeof(QChar)));
+
+    h.fileSize = quint64(out.size());
+    std::memcpy(out.data(), &h, sizeof(Header));
+
+    // QSaveFile does not create directories, and on a fresh install AppDataLocation does not exist yet
+    const QString snapshotDir = QFileInfo(snapshotPath).absolutePath();
+    if (!QDir().mkpath(snapshotDir)) {
+        qWarning() << "TweetSnapshot: Could not create" << snapshotDir;
+        return false;
+    }
+    QSaveFile file(snapshotPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "TweetSnapshot: Failed to open" << snapshotPath << "for writing:" << file.errorString();
+        return false;
+    }
+    if (file.write(out) != out.size() || !file.commit()) {
+        qWarning() << "TweetSnapshot: Failed to write" << snapshotPath << ":" << file.errorString();
+        return false;
+    }
+    qInfo() << "TweetSnapshot: Wrote" << records.size() << "records to" << snapshotPath;
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef TWEETSNAPSHOT_H
+#define TWEETSNAPSHOT_H
+
+#include "tweetdata.h"
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+// Versioned binary cache of a parsed tweet file, written next to the source
+// JSON (e.g. SCTweets_user.json -> SCTweets_user.snapshot) and memory-mapped
+// on startup. Layout: fixed header, interned UTF-16 string table, fixed-size
+// records holding string ids and list offsets, and one flat array of string
+// ids for tags/UGens. read() copies each distinct string out of the mapping
+// once and shares it between records; nothing refers to the mapping afterwards.
+// The header records the source's size, modification time and SHA-1. A
+// matching size and time is trusted as is; otherwise the source is hashed, and
+// a hash mismatch (or a bumped format version) makes read() fail so the caller
+// falls back to parsing the JSON and rewriting the snapshot.
+class TweetSnapshot
+{
+public:
+    static QString snapshotPathFor(const QString& sourcePath);
+    static QByteArray hashSourceFile(const QString& sourcePath); // Empty if unreadable
+    static QByteArray hashSourceData(const QByteArray& sourceData);
+
+    static bool read(const QString& snapshotPath, const QString& sourcePath, QVector<TweetData>& out);
+    // sourceHash is of sourcePath's current contents; its size and time are read here.
+    // Creates the snapshot's directory if needed.
+    static bool write(const QString& snapshotPath, const QString& sourcePath, const QByteArray& sourceHash,
+                      const QVector<TweetData>& tweets);
+};
+
+#endif // TWEETSNAPSHOT_H